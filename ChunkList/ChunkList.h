@@ -1,7 +1,46 @@
 ﻿#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
 #include <iterator>
+#include <limits>
 #include <memory>
+#include <new>
+#include <numeric>
+#include <ranges>
+#include <span>
 #include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define CHUNKLIST_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define CHUNKLIST_AVX2
+#else
+#define CHUNKLIST_AVX2 __attribute__((target("avx2")))
+#endif
+#else
+#define CHUNKLIST_X86 0
+#endif
+
+// MSVC keeps the standard attribute for ABI compatibility but ignores it.
+#if defined(_MSC_VER)
+#define CHUNKLIST_NO_UNIQUE_ADDRESS [[msvc::no_unique_address]]
+#else
+#define CHUNKLIST_NO_UNIQUE_ADDRESS [[no_unique_address]]
+#endif
 
 namespace fefu_laboratory_two
 {
@@ -14,330 +53,1850 @@ namespace fefu_laboratory_two
 
 		Allocator() noexcept = default;
 
-		Allocator(const Allocator& other) noexcept {};
+		Allocator(const Allocator&) noexcept {};
 
 		template <class U>
-		Allocator(const Allocator<U>& other) noexcept {};
+		Allocator(const Allocator<U>&) noexcept {};
 
 		~Allocator() = default;
 
 		pointer allocate(size_type n) {
+			if constexpr (alignof(T) > alignof(std::max_align_t))
+				return static_cast<pointer>(::operator new(sizeof(value_type) * n, std::align_val_t(alignof(T))));
 			pointer ptr = static_cast<pointer>(malloc(sizeof(value_type) * n));
 			if (ptr) return ptr;
 			throw std::bad_alloc();
 		};
 
-		void deallocate(pointer p) noexcept { free(p); };
+		void deallocate(pointer p, size_type) noexcept {
+			if constexpr (alignof(T) > alignof(std::max_align_t))
+				::operator delete(p, std::align_val_t(alignof(T)));
+			else
+				free(p);
+		};
+
+		friend bool operator==(const Allocator&, const Allocator&) noexcept { return true; };
 	};
 
-	template <typename ValueType>
-	class IChunkList {
+	/// @brief Memory resource behind PoolAllocator.
+	/// Blocks are carved from large slabs. In pool mode released blocks go to a
+	/// free list of their size and are handed out again before new memory is
+	/// carved, so chunks freed by clear, pop_back or erase are recycled. In
+	/// monotonic mode deallocation does nothing and all memory is returned at
+	/// once when the resource is destroyed, which suits build-once/read-many
+	/// lists. Not thread-safe.
+	class ChunkPool {
+		struct FreeBlock { FreeBlock* next; };
+		struct FreeList {
+			std::size_t size;
+			FreeBlock* head;
+		};
+
+		std::vector<FreeList> free_lists;
+		std::vector<std::pair<void*, std::size_t>> slabs;
+		char* cursor = nullptr;
+		char* slab_end = nullptr;
+		std::size_t slab_size;
+		bool monotonic;
+
+		static std::size_t block_size(std::size_t bytes, std::size_t alignment) noexcept {
+			std::size_t unit = std::max(alignment, sizeof(FreeBlock));
+			return (std::max(bytes, sizeof(FreeBlock)) + unit - 1) / unit * unit;
+		}
+
+		FreeList& free_list(std::size_t size) {
+			for (FreeList& list : free_lists)
+				if (list.size == size) return list;
+			free_lists.push_back({ size, nullptr });
+			return free_lists.back();
+		}
+
 	public:
-		virtual ~IChunkList() = default;
-		virtual size_t size() const noexcept = 0;
-		virtual ValueType& at(size_t pos) = 0;
-		virtual ValueType& operator[](size_t n) = 0;
+		/// @param slab_size minimal size of a slab in bytes
+		/// @param monotonic if true, memory is only returned when the pool dies
+		explicit ChunkPool(std::size_t slab_size = 64 * 1024, bool monotonic = false)
+			: slab_size(slab_size), monotonic(monotonic) {};
+
+		ChunkPool(const ChunkPool&) = delete;
+		ChunkPool& operator=(const ChunkPool&) = delete;
+
+		~ChunkPool() {
+			for (auto& slab : slabs)
+				::operator delete(slab.first, slab.second, std::align_val_t(alignof(std::max_align_t)));
+		};
+
+		void* allocate(std::size_t bytes, std::size_t alignment) {
+			std::size_t size = block_size(bytes, alignment);
+			if (!monotonic) {
+				FreeList& list = free_list(size);
+				if (list.head != nullptr) {
+					FreeBlock* block = list.head;
+					list.head = block->next;
+					return block;
+				}
+			}
+
+			std::size_t space = slab_end - cursor;
+			void* ptr = cursor;
+			if (cursor == nullptr || std::align(alignment, size, ptr, space) == nullptr) {
+				std::size_t bytes_needed = std::max(slab_size, size + alignment);
+				cursor = static_cast<char*>(::operator new(bytes_needed, std::align_val_t(alignof(std::max_align_t))));
+				slabs.push_back({ cursor, bytes_needed });
+				slab_end = cursor + bytes_needed;
+				space = bytes_needed;
+				ptr = cursor;
+				std::align(alignment, size, ptr, space);
+			}
+			cursor = static_cast<char*>(ptr) + size;
+			return ptr;
+		};
+
+		void deallocate(void* ptr, std::size_t bytes, std::size_t alignment) noexcept {
+			if (monotonic || ptr == nullptr) return;
+			FreeList& list = free_list(block_size(bytes, alignment));
+			FreeBlock* block = static_cast<FreeBlock*>(ptr);
+			block->next = list.head;
+			list.head = block;
+		};
+
+		/// @brief Total size of the slabs taken from the system, in bytes
+		std::size_t capacity() const noexcept {
+			std::size_t total = 0;
+			for (auto& slab : slabs) total += slab.second;
+			return total;
+		};
+
+		bool is_monotonic() const noexcept { return monotonic; };
 	};
 
-	template <typename value_type>
-	class Iterator {
-	protected:
-		IChunkList<value_type>* list = nullptr;
-		value_type* _current_value = nullptr;
-		int _index = 0;
+	/// @brief Allocator drawing from a shared ChunkPool. Copies, including
+	/// rebound ones, share the pool, and the pool lives as long as any of them.
+	template <typename T>
+	class PoolAllocator {
+		template <typename U> friend class PoolAllocator;
+		std::shared_ptr<ChunkPool> pool;
 	public:
-		using iterator_category = std::random_access_iterator_tag;
-		using difference_type = std::ptrdiff_t;
-		using pointer = value_type*;
-		using reference = value_type&;
+		using value_type = T;
+		using size_type = std::size_t;
+		using pointer = T*;
 
-		virtual int index() { return _index; };
+		/// @brief Creates an allocator with a new pool.
+		/// @param monotonic if true, the pool works as a monotonic arena
+		explicit PoolAllocator(bool monotonic = false)
+			: pool(std::make_shared<ChunkPool>(64 * 1024, monotonic)) {};
 
-		constexpr Iterator() noexcept = default;
+		explicit PoolAllocator(std::shared_ptr<ChunkPool> pool) noexcept : pool(std::move(pool)) {};
 
-		Iterator(IChunkList<value_type>* chunk, int index, value_type* value) :
-			list(chunk),
-			_index(index),
-			_current_value(value)
-		{};
+		template <class U>
+		PoolAllocator(const PoolAllocator<U>& other) noexcept : pool(other.pool) {};
 
-		Iterator(const Iterator& other) noexcept = default;
+		pointer allocate(size_type n) {
+			return static_cast<pointer>(pool->allocate(n * sizeof(T), alignof(T)));
+		};
 
-		Iterator& operator=(const Iterator&) = default;
+		void deallocate(pointer p, size_type n) noexcept {
+			pool->deallocate(p, n * sizeof(T), alignof(T));
+		};
 
-		virtual ~Iterator() = default;
+		/// @brief Returns the pool shared by this allocator.
+		const std::shared_ptr<ChunkPool>& resource() const noexcept { return pool; };
 
-		friend void swap(Iterator<value_type>& a, Iterator<value_type>& b) {
-			std::swap(a.list, b.list);
-			std::swap(a._current_value, b._current_value);
-			std::swap(a._index, b._index);
+		template <class U>
+		friend bool operator==(const PoolAllocator& lhs, const PoolAllocator<U>& rhs) noexcept {
+			return lhs.pool == rhs.pool;
 		};
+	};
 
-		friend bool operator==(const Iterator<value_type>& lhs,
-			const Iterator<value_type>& rhs) {
-			return lhs._current_value == rhs._current_value;
+	/// @brief Array of trivially copyable values with free slots at both ends,
+	/// used for the chunk directory. Like the std::deque map, values are added
+	/// and removed at the front in amortized constant time, not only at the
+	/// back, and a gap anywhere is opened or closed by moving the shorter side.
+	template <typename V>
+	class SlackArray {
+		static_assert(std::is_trivially_copyable_v<V>);
+
+		std::unique_ptr<V[]> buffer;
+		std::size_t room = 0;
+		std::size_t head = 0;
+		std::size_t count = 0;
+
+		/// @brief Moves the values to a buffer of slots slots, leaving front free
+		/// slots in front of them. The buffer is reused if it has that size.
+		void relayout(std::size_t slots, std::size_t front) {
+			if (slots == room) {
+				if (count > 0)
+					std::memmove(buffer.get() + front, buffer.get() + head, count * sizeof(V));
+			}
+			else {
+				std::unique_ptr<V[]> fresh(slots > 0 ? new V[slots] : nullptr);
+				if (count > 0)
+					std::memcpy(fresh.get() + front, buffer.get() + head, count * sizeof(V));
+				buffer = std::move(fresh);
+				room = slots;
+			}
+			head = front;
 		};
-		friend bool operator!=(const Iterator<value_type>& lhs,
-			const Iterator<value_type>& rhs) {
-			return !(lhs._current_value == rhs._current_value);
+
+	public:
+		SlackArray() noexcept = default;
+
+		SlackArray(const SlackArray& other)
+			: buffer(other.count > 0 ? new V[other.count] : nullptr), room(other.count), count(other.count) {
+			if (count > 0)
+				std::memcpy(buffer.get(), other.data(), count * sizeof(V));
 		};
 
-		reference operator*() const { return *_current_value; };
-		pointer operator->() const { return _current_value; };
+		SlackArray(SlackArray&& other) noexcept
+			: buffer(std::move(other.buffer)), room(std::exchange(other.room, 0)),
+			head(std::exchange(other.head, 0)), count(std::exchange(other.count, 0)) {};
 
-		Iterator operator++(int) {
-			if (_index + 1 == list->size())
-				return Iterator();
-			_index++;
-			_current_value = &list->at(_index);
+		SlackArray& operator=(SlackArray other) noexcept {
+			swap(other);
 			return *this;
 		};
-		Iterator operator--(int) {
-			_index--;
-			if (_index <= -1)
-				return *this;
 
-			_current_value = &list->at(_index);
-			return *this;
+		V* data() noexcept { return buffer.get() + head; };
+		const V* data() const noexcept { return buffer.get() + head; };
+		V* begin() noexcept { return data(); };
+		V* end() noexcept { return data() + count; };
+		const V* begin() const noexcept { return data(); };
+		const V* end() const noexcept { return data() + count; };
+
+		V& operator[](std::size_t index) noexcept { return buffer[head + index]; };
+		const V& operator[](std::size_t index) const noexcept { return buffer[head + index]; };
+		V& front() noexcept { return buffer[head]; };
+		V& back() noexcept { return buffer[head + count - 1]; };
+		const V& front() const noexcept { return buffer[head]; };
+		const V& back() const noexcept { return buffer[head + count - 1]; };
+
+		std::size_t size() const noexcept { return count; };
+		bool empty() const noexcept { return count == 0; };
+
+		/// @brief Number of values that fit from the first one to the end of the
+		/// buffer, i.e. before the back has to grow
+		std::size_t capacity() const noexcept { return room - head; };
+
+		/// @brief Number of slots of the buffer, the free ones at both ends included
+		std::size_t slots() const noexcept { return room; };
+
+		/// @brief Makes room for n values from the first one on. Free slots in
+		/// front are kept up to the number of values added, so a queue that pops
+		/// at the front and pushes at the back slides its values down instead of
+		/// growing.
+		void reserve(std::size_t n) {
+			if (head + n <= room) return;
+			std::size_t front = std::min(head, n - count);
+			relayout(std::max(room, front + n), front);
+		};
+
+		/// @brief Makes room for n values in front of the first one, keeping the
+		/// free slots at the back. The front grows at least by the number of
+		/// values.
+		void reserve_front(std::size_t n) {
+			if (n <= head) return;
+			std::size_t front = std::max(n, count);
+			relayout(room - head + front, front);
+		};
+
+		void push_back(V value) {
+			if (head + count == room)
+				reserve(std::max<std::size_t>(count * 2, 1));
+			buffer[head + count++] = value;
+		};
+
+		void push_front(V value) {
+			if (head == 0)
+				reserve_front(1);
+			buffer[--head] = value;
+			count++;
+		};
+
+		/// @brief Opens n uninitialized slots before index
+		/// @return Pointer to the first of them
+		V* insert(std::size_t index, std::size_t n) {
+			if (index < count - index && n <= head) {
+				head -= n;
+				if (index > 0)
+					std::memmove(buffer.get() + head, buffer.get() + head + n, index * sizeof(V));
+			}
+			else {
+				reserve(count + n);
+				if (index < count)
+					std::memmove(buffer.get() + head + index + n, buffer.get() + head + index, (count - index) * sizeof(V));
+			}
+			count += n;
+			return buffer.get() + head + index;
 		};
 
-		Iterator& operator++() {
-			if (_index + 1 == list->size()) {
-				this->_current_value = nullptr;
-				this->list = nullptr;
-				this->_index = 0;
-				return *this;
+		/// @brief Removes the n values from index on
+		void erase(std::size_t index, std::size_t n) {
+			std::size_t after = count - index - n;
+			if (index < after) {
+				if (index > 0)
+					std::memmove(buffer.get() + head + n, buffer.get() + head, index * sizeof(V));
+				head += n;
 			}
-			_index++;
-			_current_value = &list->at(_index);
-			return *this;
+			else if (after > 0) {
+				std::memmove(buffer.get() + head + index, buffer.get() + head + index + n, after * sizeof(V));
+			}
+			count -= n;
 		};
 
-		Iterator& operator--() {
-			_index--;
-			if (_index <= -1)
-				return *this;
+		void clear() noexcept {
+			head = 0;
+			count = 0;
+		};
 
-			_current_value = &list->at(_index);
-			return *this;
+		void shrink_to_fit() {
+			if (room != count)
+				relayout(count, 0);
 		};
 
-		Iterator operator+(const difference_type& n) const {
-			return Iterator(list, _index + n, &list->at(_index + n));
+		void swap(SlackArray& other) noexcept {
+			buffer.swap(other.buffer);
+			std::swap(room, other.room);
+			std::swap(head, other.head);
+			std::swap(count, other.count);
 		};
+	};
 
+	/// @brief Alignment of every chunk block, so a chunk starts on its own cache line.
+	inline constexpr std::size_t chunk_alignment = 64;
+
+	/// @brief What an instrumented ChunkList records into its chunk_probe
+	enum class probe_level {
+		/// Nothing, the hooks compile to nothing
+		off,
+		/// Counters only
+		counters,
+		/// Counters and the time spent in inserts and erases
+		latency,
+	};
 
-		Iterator operator-(const difference_type& n) const {
-			return Iterator(list, _index - n, &list->at(_index - n));
+	/// @brief Compile-time layout of the chunks of a ChunkList, passed in place
+	/// of the chunk size: ChunkList<T, auto_chunk<4096>> sizes its chunks to
+	/// fill 4 KiB blocks, whatever sizeof(T) is. A plain int N is the policy
+	/// with elements = N.
+	/// The default of 16 KiB blocks won or tied the ChunkSizeSweep benchmarks
+	/// for 8, 64 and 512 byte elements: smaller blocks lose on appends and
+	/// middle inserts, larger ones on middle inserts.
+	struct chunk_policy {
+		/// Target size in bytes of a chunk block, header included. Should be a
+		/// multiple of alignment, e.g. a few pages.
+		std::size_t block_bytes = 16384;
+		/// Alignment of every chunk block, a power of two
+		std::size_t alignment = chunk_alignment;
+		/// Elements per chunk, 0 derives it from block_bytes
+		int elements = 0;
+		/// Factor the chunk directory grows by when it runs out of room, so
+		/// that it is reallocated a logarithmic number of times
+		int growth = 2;
+		/// Occupancy in percent that inserts and erases in the middle keep the
+		/// chunks above, by compacting a bounded amount on every call. 0 turns
+		/// incremental compaction off, compact() is available either way.
+		/// Values up to 75 leave room for chunks that were just split.
+		int min_fill = 0;
+		/// Elements one incremental compaction step may move, 0 means a chunk
+		int compact_step = 0;
+		/// Instrumentation of the hot paths, see ChunkList::probe()
+		probe_level probe = probe_level::off;
+
+		/// @brief Chunk size N for elements of type T: elements if it is set,
+		/// otherwise as many elements as fit into block_bytes next to the header.
+		template <typename T>
+		constexpr int chunk_size() const noexcept {
+			if (elements > 0) return elements;
+			std::size_t header = (2 * sizeof(void*) + 3 * sizeof(int) + alignof(T) - 1) / alignof(T) * alignof(T);
+			return block_bytes > header + sizeof(T) ? static_cast<int>((block_bytes - header) / sizeof(T)) : 1;
 		};
+	};
 
-		Iterator& operator+=(const difference_type& n) {
-			_index += n;
-			_current_value = &list->at(_index);
-			return *this;
-		};
+	/// @brief Memory use and chunk occupancy of a ChunkList, see
+	/// ChunkList::stats()
+	struct chunk_stats {
+		/// Elements held
+		std::size_t size = 0;
+		/// Chunks held
+		std::size_t chunks = 0;
+		/// Element slots of the chunks
+		std::size_t capacity = 0;
+		/// Slots holding no element, capacity - size
+		std::size_t wasted_slots = 0;
+		/// Bytes of the chunk blocks, headers included
+		std::size_t chunk_bytes = 0;
+		/// Bytes of the buffers of the chunk directory and the chunk starts
+		std::size_t directory_bytes = 0;
+		/// Bytes of the list object, its allocator included
+		std::size_t object_bytes = 0;
+		/// chunk_bytes + directory_bytes + object_bytes
+		std::size_t allocated_bytes = 0;
+		/// fill[i] counts the chunks holding more than i/8 and at most (i + 1)/8
+		/// of a chunk, fill[0] the empty ones too
+		std::array<std::size_t, 8> fill{};
+		/// Chunks the list has allocated and let go of since it was constructed.
+		/// A chunk a snapshot still holds counts as let go when the list drops it.
+		std::size_t chunk_allocations = 0;
+		std::size_t chunk_frees = 0;
+	};
 
-		Iterator& operator-=(const difference_type& n) {
-			_index -= n;
-			_current_value = &list->at(_index);
-			return *this;
-		};
+	/// @brief Counters of an instrumented ChunkList, one whose chunk_policy sets
+	/// probe, see ChunkList::probe()
+	struct chunk_probe {
+		/// Calls of one operation and, with probe_level::latency, the time spent
+		/// in them
+		struct calls {
+			std::uint64_t count = 0;
+			std::uint64_t nanoseconds = 0;
+			/// latency[i] counts the calls that took less than 2^i and at least
+			/// 2^(i - 1) nanoseconds, the last one the longer calls too
+			std::array<std::uint64_t, 40> latency{};
+		};
+
+		/// Chunks allocated at the back by push_back, emplace_back and appends,
+		/// and at the front by push_front and emplace_front
+		std::uint64_t back_chunks = 0;
+		std::uint64_t front_chunks = 0;
+		/// Positions looked up through the chunk starts by at, operator[],
+		/// iterator jumps, insert and erase, and those of them that had to
+		/// binary search the starts instead of dividing. Const lookups may run
+		/// on several threads at once, so these two are added to atomically.
+		alignas(std::atomic_ref<std::uint64_t>::required_alignment) std::uint64_t lookups = 0;
+		alignas(std::atomic_ref<std::uint64_t>::required_alignment) std::uint64_t searches = 0;
+		/// Elements moved inside and between chunks by inserts, erases, splits
+		/// and compaction
+		std::uint64_t element_moves = 0;
+		/// Inserts and emplaces, and erases, shrinking resizes and assigns
+		calls inserts;
+		calls erases;
+	};
 
-		reference operator[](const difference_type& n) {
-			return list[n];
+	/// @brief Policy of chunks that fill blocks of Bytes bytes
+	template <std::size_t Bytes = chunk_policy().block_bytes>
+	inline constexpr chunk_policy auto_chunk{ .block_bytes = Bytes };
+
+	/// @brief Policy named by the chunk size argument of ChunkList, an element
+	/// count or a chunk_policy
+	template <auto Chunk>
+	inline constexpr chunk_policy chunk_policy_of = [] {
+		if constexpr (std::is_integral_v<decltype(Chunk)>)
+			return chunk_policy{ .elements = static_cast<int>(Chunk) };
+		else
+			return chunk_policy(Chunk);
+	}();
+
+	/// @brief Chunk size N that makes a chunk of T fill Bytes exactly, header
+	/// included. Bytes should be a multiple of chunk_alignment, e.g. a page or a
+	/// few cache lines.
+	template <typename T, std::size_t Bytes = chunk_policy().block_bytes>
+	inline constexpr int auto_chunk_size = auto_chunk<Bytes>.template chunk_size<T>();
+
+	/// @brief Sequence container of chunks of contiguous elements.
+	/// Chunk is the number of elements per chunk or a chunk_policy computing it.
+	template <typename T, auto Chunk, typename Allocator = Allocator<T>>
+	class ChunkList {
+		using alloc_traits = std::allocator_traits<Allocator>;
+
+		static constexpr chunk_policy policy = chunk_policy_of<Chunk>;
+		static constexpr int N = policy.chunk_size<T>();
+		static_assert(N > 0, "chunk size must be positive");
+		static_assert(std::has_single_bit(policy.alignment), "chunk alignment must be a power of two");
+		static_assert(policy.growth > 1, "the chunk directory must grow geometrically");
+		static_assert(policy.min_fill >= 0 && policy.min_fill <= 100, "min_fill is a percentage");
+		static_assert(policy.compact_step >= 0, "compact_step must not be negative");
+
+		static constexpr bool probing = policy.probe != probe_level::off;
+		struct no_probe {};
+		using probe_type = std::conditional_t<probing, chunk_probe, no_probe>;
+		struct probe_layout {
+			std::size_t last;
+			CHUNKLIST_NO_UNIQUE_ADDRESS probe_type probe;
+		};
+		static_assert(probing || sizeof(probe_layout) == sizeof(std::size_t), "a list that is not instrumented must not grow by its probe");
+
+		/// The header and the element storage of a chunk are one aligned block,
+		/// by default a cache line, so prev/next/size share a line with the first
+		/// elements.
+		/// The storage is raw memory, only slots [node_begin, node_begin +
+		/// node_size) hold constructed elements. Only the head chunk may have
+		/// free slots in front, left by push_front and pop_front or by an erase
+		/// near its front. Every other chunk starts at slot 0, so reaching an
+		/// element through the directory reads no chunk header but the head's.
+		/// Elements are constructed and destroyed by the list, which owns the
+		/// allocator.
+		/// refs counts the list and the snapshots holding the chunk. A chunk with
+		/// more than one owner is never written, only its links belong to the list.
+		struct alignas(std::max({ policy.alignment, alignof(T), alignof(void*) })) ChunkNode {
+			ChunkNode* prev = nullptr;
+			ChunkNode* next = nullptr;
+			int node_size = 0;
+			int node_begin = 0;
+			std::atomic<int> refs = 1;
+			union { T list[N]; };
+
+			ChunkNode() noexcept {}
+			ChunkNode(const ChunkNode&) = delete;
+			ChunkNode& operator=(const ChunkNode&) = delete;
+			~ChunkNode() {}
+
+			/// @brief Returns the first element of the chunk
+			T* data() noexcept { return list + node_begin; };
+			const T* data() const noexcept { return list + node_begin; };
+		};
+
+		/// @brief Random access iterator over the chunk chain.
+		/// Keeps the current chunk and the slot inside it, so stepping is a
+		/// pointer bump within a chunk and a hop to next/prev at chunk boundaries.
+		/// Jumps are resolved through the chunk directory. The past-the-end
+		/// iterator points one slot after the last element of the tail chunk.
+		template <bool IsConst>
+		class ChunkIterator {
+			friend class ChunkList;
+			template <bool> friend class ChunkIterator;
+			using list_pointer = std::conditional_t<IsConst, const ChunkList*, ChunkList*>;
+
+			list_pointer list = nullptr;
+			ChunkNode* node = nullptr;
+			int offset = 0;
+			int _index = 0;
+		public:
+			using iterator_concept = std::random_access_iterator_tag;
+			using iterator_category = std::random_access_iterator_tag;
+			using value_type = T;
+			using difference_type = std::ptrdiff_t;
+			using pointer = std::conditional_t<IsConst, const T*, T*>;
+			using reference = std::conditional_t<IsConst, const T&, T&>;
+
+			ChunkIterator() noexcept = default;
+
+			/// @brief Constructs an iterator to the element at position index of list.
+			ChunkIterator(list_pointer list, int index) noexcept : list(list), _index(index) {
+				list->locate(index, node, offset);
+			};
+
+			/// @brief Converts an iterator to a const iterator.
+			template <bool OtherConst, typename = std::enable_if_t<IsConst && !OtherConst>>
+			ChunkIterator(const ChunkIterator<OtherConst>& other) noexcept
+				: list(other.list), node(other.node), offset(other.offset), _index(other._index) {};
+
+			int index() const noexcept { return _index; };
+
+			reference operator*() const { return node->list[offset]; };
+			pointer operator->() const { return node->list + offset; };
+			reference operator[](difference_type n) const { return *(*this + n); };
+
+			ChunkIterator& operator++() noexcept {
+				_index++;
+				if (++offset == node->node_begin + node->node_size && node->next != nullptr) {
+					node = node->next;
+					offset = node->node_begin;
+				}
+				return *this;
+			};
+
+			ChunkIterator& operator--() noexcept {
+				_index--;
+				if (offset == node->node_begin) {
+					node = node->prev;
+					offset = node->node_begin + node->node_size;
+				}
+				offset--;
+				return *this;
+			};
+
+			ChunkIterator operator++(int) noexcept {
+				ChunkIterator tmp = *this;
+				++(*this);
+				return tmp;
+			};
+
+			ChunkIterator operator--(int) noexcept {
+				ChunkIterator tmp = *this;
+				--(*this);
+				return tmp;
+			};
+
+			ChunkIterator& operator+=(difference_type n) noexcept {
+				_index += n;
+				if (node != nullptr && offset + n >= node->node_begin && offset + n < node->node_begin + node->node_size)
+					offset += n;
+				else
+					list->locate(_index, node, offset);
+				return *this;
+			};
+
+			ChunkIterator& operator-=(difference_type n) noexcept { return *this += -n; };
+
+			friend ChunkIterator operator+(ChunkIterator it, difference_type n) noexcept { return it += n; };
+			friend ChunkIterator operator+(difference_type n, ChunkIterator it) noexcept { return it += n; };
+			friend ChunkIterator operator-(ChunkIterator it, difference_type n) noexcept { return it -= n; };
+
+			friend difference_type operator-(const ChunkIterator& lhs, const ChunkIterator& rhs) noexcept {
+				return lhs._index - rhs._index;
+			};
+
+			friend bool operator==(const ChunkIterator& lhs, const ChunkIterator& rhs) noexcept {
+				return lhs._index == rhs._index;
+			};
+
+			friend auto operator<=>(const ChunkIterator& lhs, const ChunkIterator& rhs) noexcept {
+				return lhs._index <=> rhs._index;
+			};
+		};
+		/// @brief Range over the chunks of a list, each seen as a span of its
+		/// occupied slots. Algorithms can run a plain loop over every span.
+		/// It indexes the chunk directory, so any chunk and its position are
+		/// reached in constant time and the range can be split for parallel work.
+		template <bool IsConst>
+		class ChunkRange : public std::ranges::view_interface<ChunkRange<IsConst>> {
+			ChunkNode* const* slots = nullptr;
+			const int* starts = nullptr;
+			int front = 0;
+			int count = 0;
+			int pending_from = 0;
+			int pending_shift = 0;
+		public:
+			using span_type = std::span<std::conditional_t<IsConst, const T, T>>;
+
+			class iterator {
+				ChunkNode* const* slot = nullptr;
+			public:
+				using iterator_concept = std::random_access_iterator_tag;
+				using iterator_category = std::random_access_iterator_tag;
+				using value_type = span_type;
+				using difference_type = std::ptrdiff_t;
+				using reference = span_type;
+
+				iterator() noexcept = default;
+				explicit iterator(ChunkNode* const* slot) noexcept : slot(slot) {};
+
+				span_type operator*() const noexcept { return span_type((*slot)->data(), (*slot)->node_size); };
+				span_type operator[](difference_type n) const noexcept { return *(*this + n); };
+
+				iterator& operator++() noexcept {
+					++slot;
+					return *this;
+				};
+
+				iterator& operator--() noexcept {
+					--slot;
+					return *this;
+				};
+
+				iterator operator++(int) noexcept { return iterator(slot++); };
+				iterator operator--(int) noexcept { return iterator(slot--); };
+
+				iterator& operator+=(difference_type n) noexcept {
+					slot += n;
+					return *this;
+				};
+
+				iterator& operator-=(difference_type n) noexcept {
+					slot -= n;
+					return *this;
+				};
+
+				friend iterator operator+(iterator it, difference_type n) noexcept { return it += n; };
+				friend iterator operator+(difference_type n, iterator it) noexcept { return it += n; };
+				friend iterator operator-(iterator it, difference_type n) noexcept { return it -= n; };
+				friend difference_type operator-(const iterator& lhs, const iterator& rhs) noexcept { return lhs.slot - rhs.slot; };
+				friend bool operator==(const iterator& lhs, const iterator& rhs) noexcept { return lhs.slot == rhs.slot; };
+				friend auto operator<=>(const iterator& lhs, const iterator& rhs) noexcept { return lhs.slot <=> rhs.slot; };
+			};
+
+			ChunkRange() noexcept = default;
+			ChunkRange(ChunkNode* const* slots, const int* starts, int front, int count, int pending_from = 0, int pending_shift = 0) noexcept
+				: slots(slots), starts(starts), front(front), count(count), pending_from(pending_from), pending_shift(pending_shift) {};
+
+			iterator begin() const noexcept { return iterator(slots); };
+			iterator end() const noexcept { return iterator(slots + count); };
+
+			/// @brief Number of chunks
+			std::size_t size() const noexcept { return count; };
+
+			/// @brief Position in the list of the first element of chunk index
+			std::size_t position(std::size_t index) const noexcept {
+				int start = starts[index] + (static_cast<int>(index) >= pending_from ? pending_shift : 0);
+				return std::max(start - front, 0);
+			};
+		};
+
+		/// @brief Directory slot of the chunk holding the element with the given
+		/// key, i.e. position plus front_start. While every chunk but the head
+		/// and the tail is full and the head ends at slot N, as after push_back or
+		/// push_front, this is a division, otherwise the starts are binary
+		/// searched.
+		static int chunk_of(const SlackArray<int>& starts, int key) noexcept {
+			const int* start = starts.data();
+			int count = static_cast<int>(starts.size());
+			if (start[count - 1] - start[0] == (count - 1) * N)
+				return (key - start[0]) / N;
+			return static_cast<int>(std::upper_bound(start, start + count, key) - start) - 1;
+		};
+
+		/// @brief Read-only view of a list as it was when snapshot() was called.
+		/// It holds the chunks of the list instead of copies, so taking it costs
+		/// a copy of the chunk directory. While a snapshot holds a chunk, the list
+		/// copies the chunk before writing to it, and the view never changes.
+		/// A snapshot may be read and released on other threads while the list is
+		/// modified, as long as the allocator is thread-safe. It never follows the
+		/// links of its chunks, which belong to the list.
+		class Snapshot {
+			friend class ChunkList;
+
+			Allocator allocator;
+			SlackArray<ChunkNode*> directory;
+			SlackArray<int> chunk_start;
+			int front_start = 0;
+			int list_size = 0;
+
+			explicit Snapshot(const ChunkList& list)
+				: allocator(list.allocator), directory(list.directory), chunk_start(list.chunk_start),
+				front_start(list.front_start), list_size(list.list_size) {
+				for (ChunkNode* node : directory)
+					node->refs.fetch_add(1, std::memory_order_relaxed);
+			};
+
+			/// @brief Finds the chunk holding position pos and the offset inside it.
+			/// Position size() maps to the slot after the last element.
+			void locate(int pos, int& chunk, int& offset) const noexcept {
+				int count = static_cast<int>(directory.size());
+				if (pos == list_size) {
+					chunk = count > 0 ? count - 1 : 0;
+					offset = count > 0 ? directory[chunk]->node_begin + directory[chunk]->node_size : 0;
+					return;
+				}
+				chunk = chunk_of(chunk_start, front_start + pos);
+				offset = front_start + pos - chunk_start[chunk];
+			};
+
+		public:
+			/// @brief Random access iterator over the elements of a snapshot.
+			/// Steps from chunk to chunk through the directory of the snapshot.
+			class const_iterator {
+				const Snapshot* view = nullptr;
+				int chunk = 0;
+				int offset = 0;
+				int _index = 0;
+			public:
+				using iterator_concept = std::random_access_iterator_tag;
+				using iterator_category = std::random_access_iterator_tag;
+				using value_type = T;
+				using difference_type = std::ptrdiff_t;
+				using pointer = const T*;
+				using reference = const T&;
+
+				const_iterator() noexcept = default;
+
+				/// @brief Constructs an iterator to the element at position index of view.
+				const_iterator(const Snapshot* view, int index) noexcept : view(view), _index(index) {
+					view->locate(index, chunk, offset);
+				};
+
+				int index() const noexcept { return _index; };
+
+				reference operator*() const { return view->directory[chunk]->list[offset]; };
+				pointer operator->() const { return view->directory[chunk]->list + offset; };
+				reference operator[](difference_type n) const { return *(*this + n); };
+
+				const_iterator& operator++() noexcept {
+					_index++;
+					const ChunkNode* node = view->directory[chunk];
+					if (++offset == node->node_begin + node->node_size && chunk + 1 < static_cast<int>(view->directory.size()))
+						offset = view->directory[++chunk]->node_begin;
+					return *this;
+				};
+
+				const_iterator& operator--() noexcept {
+					_index--;
+					if (offset == view->directory[chunk]->node_begin) {
+						const ChunkNode* node = view->directory[--chunk];
+						offset = node->node_begin + node->node_size;
+					}
+					offset--;
+					return *this;
+				};
+
+				const_iterator operator++(int) noexcept {
+					const_iterator tmp = *this;
+					++(*this);
+					return tmp;
+				};
+
+				const_iterator operator--(int) noexcept {
+					const_iterator tmp = *this;
+					--(*this);
+					return tmp;
+				};
+
+				const_iterator& operator+=(difference_type n) noexcept {
+					_index += static_cast<int>(n);
+					view->locate(_index, chunk, offset);
+					return *this;
+				};
+
+				const_iterator& operator-=(difference_type n) noexcept { return *this += -n; };
+
+				friend const_iterator operator+(const_iterator it, difference_type n) noexcept { return it += n; };
+				friend const_iterator operator+(difference_type n, const_iterator it) noexcept { return it += n; };
+				friend const_iterator operator-(const_iterator it, difference_type n) noexcept { return it -= n; };
+
+				friend difference_type operator-(const const_iterator& lhs, const const_iterator& rhs) noexcept {
+					return lhs._index - rhs._index;
+				};
+
+				friend bool operator==(const const_iterator& lhs, const const_iterator& rhs) noexcept {
+					return lhs._index == rhs._index;
+				};
+
+				friend auto operator<=>(const const_iterator& lhs, const const_iterator& rhs) noexcept {
+					return lhs._index <=> rhs._index;
+				};
+			};
+
+			using value_type = T;
+			using size_type = std::size_t;
+			using difference_type = std::ptrdiff_t;
+			using const_reference = const T&;
+			using iterator = const_iterator;
+			using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+			/// @brief Constructs an empty snapshot
+			Snapshot() = default;
+
+			/// @brief Shares the chunks of other, no element is copied
+			Snapshot(const Snapshot& other)
+				: allocator(other.allocator), directory(other.directory), chunk_start(other.chunk_start),
+				front_start(other.front_start), list_size(other.list_size) {
+				for (ChunkNode* node : directory)
+					node->refs.fetch_add(1, std::memory_order_relaxed);
+			};
+
+			Snapshot(Snapshot&& other) noexcept
+				: allocator(other.allocator), directory(std::move(other.directory)), chunk_start(std::move(other.chunk_start)),
+				front_start(other.front_start), list_size(std::exchange(other.list_size, 0)) {
+				other.directory.clear();
+				other.chunk_start.clear();
+			};
+
+			Snapshot& operator=(Snapshot other) noexcept {
+				std::swap(allocator, other.allocator);
+				directory.swap(other.directory);
+				chunk_start.swap(other.chunk_start);
+				std::swap(front_start, other.front_start);
+				std::swap(list_size, other.list_size);
+				return *this;
+			};
+
+			/// @brief Releases the chunks. A chunk the list no longer holds is
+			/// destroyed by its last snapshot.
+			~Snapshot() {
+				for (ChunkNode* node : directory)
+					release_node(allocator, node);
+			};
+
+			const_iterator begin() const noexcept { return const_iterator(this, 0); };
+			const_iterator end() const noexcept { return const_iterator(this, list_size); };
+			const_iterator cbegin() const noexcept { return begin(); };
+			const_iterator cend() const noexcept { return end(); };
+			const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator(end()); };
+			const_reverse_iterator rend() const noexcept { return const_reverse_iterator(begin()); };
+
+			/// @brief Returns the chunks of the snapshot in order, each as a
+			/// std::span over its constant elements.
+			ChunkRange<true> chunks() const noexcept {
+				return ChunkRange<true>(directory.data(), chunk_start.data(), front_start, static_cast<int>(directory.size()));
+			};
+
+			bool empty() const noexcept { return !list_size; };
+			size_type size() const noexcept { return list_size; };
+
+			/// @brief Returns the element at position pos, no bounds checking
+			const_reference operator[](size_type pos) const {
+				int key = front_start + static_cast<int>(pos);
+				int index = chunk_of(chunk_start, key);
+				return directory[index]->list[key - chunk_start[index]];
+			};
+
+			/// @brief Returns the element at position pos
+			/// @throw std::out_of_range
+			const_reference at(size_type pos) const {
+				if (pos >= size()) throw std::out_of_range("Out of range");
+				return (*this)[pos];
+			};
+
+			const_reference front() const {
+				if (!list_size) throw std::logic_error("Empty container");
+				return directory.front()->data()[0];
+			};
+
+			const_reference back() const {
+				if (!list_size) throw std::logic_error("Empty container");
+				return directory.back()->data()[directory.back()->node_size - 1];
+			};
 		};
 
-		friend bool operator<(const Iterator<value_type>& lhs,
-			const Iterator<value_type>& rhs) {
-			return rhs._index - lhs._index > 0;
+	public:
+		using value_type = T;
+		using allocator_type = Allocator;
+		using size_type = std::size_t;
+		using difference_type = std::ptrdiff_t;
+		using reference = value_type&;
+		using const_reference = const value_type&;
+		using pointer = value_type*;
+		using const_pointer = const pointer;
+		using iterator = ChunkIterator<false>;
+		using const_iterator = ChunkIterator<true>;
+		using reverse_iterator = std::reverse_iterator<iterator>;
+		using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+		using chunk_range = ChunkRange<false>;
+		using const_chunk_range = ChunkRange<true>;
+		using snapshot_type = Snapshot;
+
+		/// @brief Number of elements a chunk holds
+		static constexpr int chunk_size = N;
+
+		/// @brief Size in bytes of one chunk block, header included
+		static constexpr std::size_t chunk_bytes = sizeof(ChunkNode);
+
+	protected:
+		using node_allocator = typename alloc_traits::template rebind_alloc<ChunkNode>;
+		using node_traits = std::allocator_traits<node_allocator>;
+
+		/// Constructs elements, rebound to ChunkNode it allocates whole chunks.
+		Allocator allocator;
+		ChunkNode* first = nullptr;
+		ChunkNode* last = nullptr;
+		int chunk_count = 0;
+		int list_size = 0;
+		/// Chunk pointers in list order, like the std::deque map, so that the
+		/// chunk holding a position is found without walking next links.
+		SlackArray<ChunkNode*> directory;
+		/// Start of every chunk in directory: the key of its storage slot 0,
+		/// where the key of an element is its position plus front_start. Chunks
+		/// may be partially filled after insert and erase; the starts are the
+		/// prefix sums of their sizes, binary searched in O(log chunks). The slot
+		/// of a key is key - start_of(i), whatever free slots the head has in
+		/// front.
+		SlackArray<int> chunk_start;
+		/// Key of position 0. Keys are only ever compared and subtracted, so the
+		/// starts in front of a change may be moved instead of the ones after it,
+		/// and push_front and pop_front only move front_start.
+		int front_start = base_start;
+		/// Shift of the starts from slot pending_from of the directory on that is
+		/// not yet added to them: the start of chunk i is chunk_start[i] +
+		/// pending_shift for i >= pending_from. Like the gap of a gap buffer, it
+		/// follows inserts and erases in the middle, so edits close to each other
+		/// touch the starts between them instead of half the directory.
+		/// pending_from is below chunk_count while pending_shift is not 0.
+		int pending_from = 0;
+		int pending_shift = 0;
+		/// Set by snapshot(): chunks may be shared and are checked before a write.
+		bool shared = false;
+		/// Directory slot the next incremental compaction step starts from. Only
+		/// a hint, it is checked against chunk_count before use.
+		int compact_cursor = 0;
+		/// Chunks allocated and let go of by this object, reported by stats().
+		/// They stay with the object when its contents are moved or swapped.
+		std::size_t chunk_allocations = 0;
+		std::size_t chunk_frees = 0;
+		/// Counters of the probe hooks, empty unless policy.probe is set, and then
+		/// without an address of its own (probe_layout checks that). Const
+		/// lookups count too, with relaxed atomic adds, so an instrumented list
+		/// may still be read from several threads at once, e.g. by the
+		/// ChunkListParallel.h algorithms.
+		CHUNKLIST_NO_UNIQUE_ADDRESS mutable probe_type probe_data;
+
+		/// @brief Adds n to a counter of the probe
+		void tally(std::uint64_t chunk_probe::* counter, std::uint64_t n = 1) const noexcept {
+			if constexpr (probing)
+				probe_data.*counter += n;
+		};
+
+		/// @brief Counts a call into its chunk_probe::calls and, with
+		/// probe_level::latency, adds the time until it goes out of scope.
+		class probe_scope {
+			chunk_probe::calls& calls;
+			std::chrono::steady_clock::time_point start;
+		public:
+			explicit probe_scope(chunk_probe::calls& calls) noexcept : calls(calls) {
+				calls.count++;
+				if constexpr (policy.probe == probe_level::latency)
+					start = std::chrono::steady_clock::now();
+			};
+
+			probe_scope(const probe_scope&) = delete;
+			probe_scope& operator=(const probe_scope&) = delete;
+
+			~probe_scope() {
+				if constexpr (policy.probe == probe_level::latency) {
+					auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+					auto ns = static_cast<std::uint64_t>(std::max<decltype(elapsed)>(elapsed, 0));
+					calls.nanoseconds += ns;
+					calls.latency[std::min<std::size_t>(std::bit_width(ns), calls.latency.size() - 1)]++;
+				}
+			};
 		};
-		friend bool operator<=(const Iterator<value_type>& lhs,
-			const Iterator<value_type>& rhs) {
-			return !(rhs._index > lhs._index);
+
+		/// @brief Starts a probe_scope for the calls of the probe named by which,
+		/// or nothing if the list is not instrumented
+		auto probe_call(chunk_probe::calls chunk_probe::* which) noexcept {
+			if constexpr (probing)
+				return probe_scope(probe_data.*which);
+			else
+				return no_probe();
 		};
-		friend bool operator>(const Iterator<value_type>& lhs,
-			const Iterator<value_type>& rhs) {
-			return rhs._index < lhs._index;
+
+		/// Slots passed to construct, destroy and relocate count from node_begin,
+		/// so slot 0 holds the first element of the chunk and slot -1 is the free
+		/// slot in front of it.
+
+		/// @brief Constructs an element in the free slot index of node
+		template <class... Args>
+		void construct(ChunkNode* node, int index, Args&&... args) {
+			alloc_traits::construct(allocator, node->data() + index, std::forward<Args>(args)...);
 		};
-		friend bool operator>=(const Iterator<value_type>& lhs,
-			const Iterator<value_type>& rhs) {
-			return !(lhs._index < rhs._index);
+
+		/// @brief Destroys the elements in slots [from, to) of node
+		void destroy(ChunkNode* node, int from, int to) noexcept {
+			if constexpr (!std::is_trivially_destructible_v<T>) {
+				T* slots = node->data();
+				for (int i = from; i < to; i++)
+					alloc_traits::destroy(allocator, slots + i);
+			}
 		};
-	};
 
-	template <typename value_type>
-	class ConstIterator : public Iterator<value_type> {
-	public:
-		using iterator_category = std::random_access_iterator_tag;
-		using difference_type = std::ptrdiff_t;
-		using const_pointer = const value_type*;
-		using const_reference = const value_type&;
-		constexpr ConstIterator() : Iterator<value_type>() {};
-		ConstIterator(IChunkList<value_type>* chunk, int index, value_type* value) :
-			Iterator<value_type>(chunk, index, value) {};
+		/// @brief Moves count elements from slots [from, from + count) of src to the
+		/// free slots [to, to + count) of dst and leaves the source slots free.
+		/// src and dst may be the same chunk.
+		void relocate(ChunkNode* src, int from, ChunkNode* dst, int to, int count) {
+			tally(&chunk_probe::element_moves, count);
+			T* source = src->data() + from;
+			T* target = dst->data() + to;
+			if constexpr (std::is_trivially_copyable_v<T>) {
+				if (count > 0)
+					std::memmove(target, source, count * sizeof(T));
+			}
+			else if (src == dst && to > from) {
+				for (int i = count - 1; i >= 0; i--) {
+					alloc_traits::construct(allocator, target + i, std::move(source[i]));
+					alloc_traits::destroy(allocator, source + i);
+				}
+			}
+			else {
+				for (int i = 0; i < count; i++) {
+					alloc_traits::construct(allocator, target + i, std::move(source[i]));
+					alloc_traits::destroy(allocator, source + i);
+				}
+			}
+		};
 
-		ConstIterator(const IChunkList<value_type>* chunk, int index, const value_type* value) :
-			Iterator<value_type>(const_cast<IChunkList<value_type>*>(chunk), index, const_cast<value_type*>(value)) {};
+		/// @brief Moves the elements of node to the front of its storage, so that
+		/// all its free slots follow them.
+		void pack(ChunkNode* node) {
+			int begin = node->node_begin;
+			if (begin == 0) return;
+			node->node_begin = 0;
+			relocate(node, begin, node, 0, node->node_size);
+			if (node == first)
+				set_start(0, front_start);
+		};
+
+		/// @brief Opens count free slots before slot offset of node, which has room
+		/// for them. In the head chunk the elements on the shorter side of offset
+		/// are moved, the ones in front of it only if the free slots in front are
+		/// enough. In other chunks the elements after offset are moved.
+		void open_gap(ChunkNode* node, int offset, int count) {
+			int after = node->node_size - offset;
+			bool back_room = node->node_begin + node->node_size + count <= N;
+			if (node == first && node->node_begin >= count && (offset < after || !back_room)) {
+				relocate(node, 0, node, -count, offset);
+				node->node_begin -= count;
+				set_start(0, front_start - node->node_begin);
+			}
+			else {
+				if (!back_room)
+					pack(node);
+				relocate(node, offset, node, offset + count, after);
+			}
+		};
 
-		ConstIterator(const ConstIterator& other) noexcept = default;
+		/// @brief Destroys the count elements from slot offset of node and closes
+		/// the gap. The head chunk moves the elements on the shorter side of the
+		/// gap, so erasing at its front moves nothing. Other chunks move the
+		/// elements after the gap.
+		void close_gap(ChunkNode* node, int offset, int count) {
+			destroy(node, offset, offset + count);
+			int after = node->node_size - offset - count;
+			if (node == first && offset < after) {
+				relocate(node, 0, node, count, offset);
+				node->node_begin += count;
+				set_start(0, front_start - node->node_begin);
+			}
+			else {
+				relocate(node, offset + count, node, offset, after);
+			}
+			node->node_size -= count;
+		};
 
-		ConstIterator& operator=(const ConstIterator&) = default;
+		/// True when the allocator leaves element construction to placement new,
+		/// so whole runs of slots can be filled with the uninitialized algorithms
+		/// (a memcpy/memset for trivial types).
+		static constexpr bool bulk_construct = !requires(Allocator& alloc, T* p, const T& value) {
+			alloc.construct(p, value);
+		};
 
-		~ConstIterator() override = default;
+		/// @brief Allocates an empty chunk from the allocator
+		ChunkNode* create_node() {
+			node_allocator node_alloc(allocator);
+			ChunkNode* node = ::new (static_cast<void*>(node_traits::allocate(node_alloc, 1))) ChunkNode();
+			chunk_allocations++;
+			return node;
+		};
 
-		friend void swap(ConstIterator<value_type>& a, ConstIterator<value_type>& b) {
-			std::swap(a.list, b.list);
-			std::swap(a._current_value, b._current_value);
-			std::swap(a._index, b._index);
+		/// @brief Allocates a chunk holding copies of the elements of other
+		ChunkNode* create_node(const ChunkNode* other) {
+			ChunkNode* node = create_node();
+			node->node_begin = other->node_begin;
+			try {
+				if constexpr (bulk_construct) {
+					std::uninitialized_copy_n(other->data(), other->node_size, node->data());
+					node->node_size = other->node_size;
+				}
+				else {
+					for (; node->node_size < other->node_size; node->node_size++)
+						construct(node, node->node_size, other->data()[node->node_size]);
+				}
+			}
+			catch (...) {
+				destroy_node(node);
+				throw;
+			}
+			return node;
+		};
+
+		/// @brief Drops one owner of a chunk. The last owner destroys its elements
+		/// and gives its block back to alloc.
+		static void release_node(Allocator& alloc, ChunkNode* node) noexcept {
+			if (node->refs.load(std::memory_order_acquire) != 1 && node->refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+				return;
+			if constexpr (!std::is_trivially_destructible_v<T>)
+				for (int i = 0; i < node->node_size; i++)
+					alloc_traits::destroy(alloc, node->data() + i);
+			node->~ChunkNode();
+			node_allocator node_alloc(alloc);
+			node_traits::deallocate(node_alloc, node, 1);
+		};
+
+		/// @brief Destroys the elements of a chunk and gives its block back to the
+		/// allocator, or only lets it go if a snapshot still holds it
+		void destroy_node(ChunkNode* node) noexcept {
+			chunk_frees++;
+			release_node(allocator, node);
+		};
+
+		/// @brief Makes the chunk at slot index of the directory private to this
+		/// list before it is written. A chunk a snapshot still holds is replaced
+		/// by a copy, the snapshot keeps the original.
+		/// @return The chunk now in the slot.
+		ChunkNode* own(int index) {
+			ChunkNode* node = directory[index];
+			if (shared && node->refs.load(std::memory_order_acquire) != 1)
+				return unshare(index);
+			return node;
+		};
+
+		/// @brief Replaces the shared chunk at slot index of the directory by a
+		/// private copy
+		/// @return The copy.
+		ChunkNode* unshare(int index) {
+			ChunkNode* node = directory[index];
+			if constexpr (!std::is_copy_constructible_v<T>) {
+				return node;
+			}
+			else {
+				ChunkNode* copy = create_node(node);
+				copy->prev = node->prev;
+				copy->next = node->next;
+				if (copy->prev != nullptr)
+					copy->prev->next = copy;
+				else
+					first = copy;
+				if (copy->next != nullptr)
+					copy->next->prev = copy;
+				else
+					last = copy;
+				directory[index] = copy;
+				destroy_node(node);
+				return copy;
+			}
 		};
 
-		friend bool operator==(const ConstIterator<value_type>& lhs,
-			const ConstIterator<value_type>& rhs) {
-			return lhs._current_value == rhs._current_value;
+		/// @brief Makes the chunk holding position index private to this list, if
+		/// there is such a position. Lets the iterator erase returns write the
+		/// element it points to.
+		void own_at(int index) {
+			if (shared && index < list_size)
+				own(chunk_index(index));
+		};
+
+		/// @brief Makes every chunk private to this list. Called before mutable
+		/// iterators or spans are handed out, since they can write anywhere.
+		void own_all() {
+			if (!shared) return;
+			for (int i = 0; i < chunk_count; i++)
+				own(i);
+			shared = false;
+		};
+
+		/// @brief Links count chunks, in order, after the chunk after (at the front
+		/// if after is nullptr) and registers them from slot index of the directory.
+		/// Sizes of the linked chunks must be final, positions of the chunks that
+		/// follow them are not updated.
+		void link_chunks(ChunkNode* const* nodes, int count, ChunkNode* after, int index) {
+			ChunkNode* next = after != nullptr ? after->next : first;
+			ChunkNode* prev = after;
+			for (int i = 0; i < count; i++) {
+				nodes[i]->prev = prev;
+				if (prev != nullptr)
+					prev->next = nodes[i];
+				else
+					first = nodes[i];
+				prev = nodes[i];
+			}
+			prev->next = next;
+			if (next != nullptr)
+				next->prev = prev;
+			else
+				last = prev;
+
+			reserve_chunks(chunk_count + count);
+			std::copy_n(nodes, count, directory.insert(index, count));
+			chunk_start.insert(index, count);
+			if (index <= pending_from)
+				pending_from += count;
+			if (chunk_count == 0)
+				front_start = base_start;
+			update_starts(index, index + count);
+			chunk_count += count;
+		};
+
+		/// @brief Makes room for count chunks in the directory. It grows by the
+		/// growth factor of the policy, at least to count.
+		void reserve_chunks(size_type count) {
+			size_type capacity = std::min(directory.capacity(), chunk_start.capacity());
+			if (count <= capacity) return;
+			count = std::max(count, capacity * policy.growth);
+			directory.reserve(count);
+			chunk_start.reserve(count);
+		};
+
+		/// @brief Links a new empty chunk after the last one and makes it the tail
+		/// @return Pointer to the new tail chunk
+		ChunkNode* append_chunk() {
+			tally(&chunk_probe::back_chunks);
+			reserve_chunks(chunk_count + 1);
+			ChunkNode* node = create_node();
+			node->prev = last;
+			if (last != nullptr)
+				last->next = node;
+			else
+				first = node;
+			last = node;
+
+			directory.push_back(node);
+			if (chunk_count == 0)
+				front_start = base_start;
+			chunk_start.push_back(front_start + list_size - pending_shift);
+			chunk_count++;
+			return node;
+		};
+
+		/// @brief Links a new empty chunk before the first one and makes it the
+		/// head. Its free slots are in front, so that push_front fills it from the
+		/// back.
+		/// @return Pointer to the new head chunk
+		ChunkNode* prepend_chunk() {
+			tally(&chunk_probe::front_chunks);
+			directory.reserve_front(1);
+			chunk_start.reserve_front(1);
+			ChunkNode* node = create_node();
+			node->node_begin = N;
+			node->next = first;
+			if (first != nullptr)
+				first->prev = node;
+			else
+				last = node;
+			first = node;
+
+			if (chunk_count == 0)
+				front_start = base_start;
+			chunk_start.push_front(front_start - N);
+			directory.push_front(node);
+			if (pending_shift != 0)
+				pending_from++;
+			chunk_count++;
+			return node;
+		};
+
+		/// @brief Appends count elements, topping up the tail chunk and then filling
+		/// new chunks whole. fill(dst, n) constructs n elements in the raw slots
+		/// starting at dst.
+		template <class Fill>
+		void append_block(size_type count, Fill fill) {
+			reserve_chunks(chunk_count + (count + N - 1) / N + 1);
+			while (count > 0) {
+				ChunkNode* node = last;
+				if (node == nullptr || node->node_begin + node->node_size == N)
+					node = append_chunk();
+				else if (shared)
+					node = own(chunk_count - 1);
+				int n = static_cast<int>(std::min<size_type>(count, N - node->node_begin - node->node_size));
+				try {
+					fill(node->data() + node->node_size, n);
+				}
+				catch (...) {
+					if (node->node_size == 0)
+						remove_last_chunk();
+					throw;
+				}
+				node->node_size += n;
+				list_size += n;
+				count -= n;
+			}
 		};
-		friend bool operator!=(const ConstIterator<value_type>& lhs,
-			const ConstIterator<value_type>& rhs) {
-			return !(lhs._current_value == rhs._current_value);
+
+		/// @brief Appends copies of count elements starting at first
+		template <class ForwardIt>
+		void append_copy(ForwardIt first, size_type count) {
+			if constexpr (bulk_construct)
+				append_block(count, [&first](T* dst, int n) {
+					first = std::ranges::uninitialized_copy_n(first, n, dst, dst + n).in;
+				});
+			else
+				for (; count > 0; count--, ++first) emplace_back(*first);
 		};
 
-		const_reference operator*() const { return *this->_current_value; };
-		const_pointer operator->() const { return this->_current_value; };
-		const_reference operator[](const difference_type& n) {
-			return this->list[n];
+		/// @brief Appends count copies of value
+		void append_fill(size_type count, const T& value) {
+			if constexpr (bulk_construct)
+				append_block(count, [&value](T* dst, int n) { std::uninitialized_fill_n(dst, n, value); });
+			else
+				for (; count > 0; count--) emplace_back(value);
 		};
 
-		ConstIterator operator++(int) {
-			if (this->_index + 1 == this->list->size())
-				return ConstIterator();
-			this->_index++;
-			this->_current_value = &this->list->at(this->_index);
-			return *this;
+		/// @brief Appends count value-initialized elements
+		void append_default(size_type count) {
+			if constexpr (bulk_construct)
+				append_block(count, [](T* dst, int n) { std::uninitialized_value_construct_n(dst, n); });
+			else
+				for (; count > 0; count--) emplace_back();
 		};
 
-		ConstIterator operator--(int) {
-			return Iterator<value_type>::operator--(0);
+		/// Result of comparing elements: the result of <=> if T has it, otherwise
+		/// a weak ordering built from <.
+		using synth_ordering = typename std::conditional_t<std::three_way_comparable<T>,
+			std::compare_three_way_result<T>, std::type_identity<std::weak_ordering>>::type;
+
+		static synth_ordering synth_three_way(const T& a, const T& b) {
+			if constexpr (std::three_way_comparable<T>)
+				return a <=> b;
+			else
+				return a < b ? std::weak_ordering::less : b < a ? std::weak_ordering::greater : std::weak_ordering::equivalent;
+		};
+
+		/// @brief Walks the first count elements of lhs and rhs in step and hands
+		/// visit(a, b, n) the longest runs contiguous in both chains, until visit
+		/// returns false.
+		template <class Visit>
+		static void compare_runs(const ChunkList& lhs, const ChunkList& rhs, int count, Visit visit) {
+			const ChunkNode* a = lhs.first;
+			const ChunkNode* b = rhs.first;
+			int a_offset = 0;
+			int b_offset = 0;
+			while (count > 0) {
+				if (a_offset == a->node_size) {
+					a = a->next;
+					a_offset = 0;
+				}
+				if (b_offset == b->node_size) {
+					b = b->next;
+					b_offset = 0;
+				}
+				int n = std::min({ count, a->node_size - a_offset, b->node_size - b_offset });
+				if (!visit(a->data() + a_offset, b->data() + b_offset, n))
+					return;
+				a_offset += n;
+				b_offset += n;
+				count -= n;
+			}
 		};
 
-		ConstIterator& operator++() {
-			if (this->_index + 1 == this->list->size()) {
-				this->_current_value = nullptr;
-				this->list = nullptr;
-				this->_index = 0;
-				return *this;
+		/// @brief Takes over the chunks of other and leaves it empty. The chunks
+		/// of this list must have been released and the allocators must be equal.
+		void steal(ChunkList& other) noexcept {
+			first = std::exchange(other.first, nullptr);
+			last = std::exchange(other.last, nullptr);
+			chunk_count = std::exchange(other.chunk_count, 0);
+			list_size = std::exchange(other.list_size, 0);
+			front_start = other.front_start;
+			pending_from = other.pending_from;
+			pending_shift = std::exchange(other.pending_shift, 0);
+			shared = std::exchange(other.shared, false);
+			directory = std::move(other.directory);
+			chunk_start = std::move(other.chunk_start);
+			other.directory.clear();
+			other.chunk_start.clear();
+		};
+
+		/// @brief Copy-assigns the elements of other over the elements already in
+		/// place, chunk run by chunk run, then appends or erases the difference.
+		/// Chunks and element resources of this list are reused, unless a snapshot
+		/// shares them.
+		void assign_reusing(const ChunkList& other) {
+			if (shared)
+				clear();
+			int common = std::min(list_size, other.list_size);
+			ChunkNode* dst = first;
+			const ChunkNode* src = other.first;
+			int dst_offset = 0;
+			int src_offset = 0;
+			for (int left = common; left > 0;) {
+				if (dst_offset == dst->node_size) {
+					dst = dst->next;
+					dst_offset = 0;
+				}
+				if (src_offset == src->node_size) {
+					src = src->next;
+					src_offset = 0;
+				}
+				int n = std::min({ left, dst->node_size - dst_offset, src->node_size - src_offset });
+				std::copy_n(src->data() + src_offset, n, dst->data() + dst_offset);
+				dst_offset += n;
+				src_offset += n;
+				left -= n;
 			}
-			this->_index++;
-			this->_current_value = &this->list->at(this->_index);
-			return *this;
+			if (list_size > common)
+				erase_block(common, list_size - common);
+			else
+				append_copy(other.begin() + common, other.list_size - common);
 		};
 
-		ConstIterator& operator--() {
-			if (this->_index - 1 == -1)
-				throw std::exception();
-			this->_index--;
-			this->_current_value = &this->list->at(this->_index);
-			return *this;
+		/// @brief Unlinks and deletes count chunks starting at slot index of the
+		/// directory. Positions of the following chunks are not updated.
+		void erase_chunks(int index, int count) {
+			if (count <= 0) return;
+			ChunkNode* prev = directory[index]->prev;
+			ChunkNode* next = directory[index + count - 1]->next;
+			if (prev != nullptr)
+				prev->next = next;
+			else
+				first = next;
+			if (next != nullptr)
+				next->prev = prev;
+			else
+				last = prev;
+
+			for (int i = index; i < index + count; i++)
+				destroy_node(directory[i]);
+			directory.erase(index, count);
+			chunk_start.erase(index, count);
+			chunk_count -= count;
+			if (index < pending_from)
+				pending_from = std::max(index, pending_from - count);
+			if (pending_from >= chunk_count)
+				pending_shift = 0;
 		};
 
-		ConstIterator operator+(const difference_type& n) const {
-			return ConstIterator(this->list, this->_index + n, &this->list->at(this->_index + n));
+		/// @brief Unlinks and deletes the tail chunk
+		void remove_last_chunk() {
+			erase_chunks(chunk_count - 1, 1);
 		};
 
+		/// @brief Returns the start of the chunk at slot index of the directory
+		int start_of(int index) const noexcept {
+			return chunk_start[index] + (index >= pending_from ? pending_shift : 0);
+		};
 
-		ConstIterator operator-(const difference_type& n) const {
-			return ConstIterator(this->list, this->_index - n, &this->list->at(this->_index - n));
+		/// @brief Sets the start of the chunk at slot index of the directory
+		void set_start(int index, int key) noexcept {
+			chunk_start[index] = key - (index >= pending_from ? pending_shift : 0);
 		};
 
-		ConstIterator& operator+=(const difference_type& n) {
-			this->_index += n;
-			this->_current_value = &this->list->at(this->_index);
-			return *this;
+		/// @brief Adds the pending shift to the starts it covers.
+		void settle_starts() noexcept {
+			if (pending_shift == 0) return;
+			int* start = chunk_start.data();
+			for (int i = pending_from, end = chunk_count; i < end; i++)
+				start[i] += pending_shift;
+			pending_shift = 0;
 		};
 
-		ConstIterator& operator-=(const difference_type& n) {
-			this->_index -= n;
-			this->_current_value = &this->list->at(this->_index);
-			return *this;
+		/// @brief Recomputes the starts of the chunks in slots [from, to) of the
+		/// directory from the chunk in front of them, or from front_start.
+		void update_starts(int from, int to) {
+			int key = front_start;
+			if (from > 0) {
+				const ChunkNode* prev = directory[from - 1];
+				key = start_of(from - 1) + prev->node_begin + prev->node_size;
+			}
+			for (int i = from; i < to; i++) {
+				set_start(i, key - directory[i]->node_begin);
+				key += directory[i]->node_size;
+			}
+		};
+
+		/// @brief Moves the positions of the chunks from slot index of the directory
+		/// to the end by delta, whichever way touches the fewest starts: moving
+		/// the starts in front of index and front_start by -delta, which is the
+		/// same to positions, moving the starts from index on, or moving the
+		/// pending shift to index and adding delta to it.
+		void shift_starts(int index, int delta) {
+			int count = chunk_count;
+			if (index >= count) return;
+			int* start = chunk_start.data();
+			int distance = pending_shift != 0 ? std::abs(index - pending_from) : 0;
+			if (index <= distance && index <= count - index) {
+				for (int i = 0; i < index; i++)
+					start[i] -= delta;
+				front_start -= delta;
+				rebase_starts();
+			}
+			else if (count - index < distance) {
+				for (int i = index; i < count; i++)
+					start[i] += delta;
+			}
+			else {
+				if (pending_shift != 0) {
+					for (int i = pending_from; i < index; i++)
+						start[i] += pending_shift;
+					for (int i = index; i < pending_from; i++)
+						start[i] -= pending_shift;
+				}
+				pending_from = index;
+				pending_shift += delta;
+			}
 		};
 
-		friend bool operator<(const ConstIterator<value_type>& lhs,
-			const ConstIterator<value_type>& rhs) {
-			return rhs._index - lhs._index > 0;
+		/// front_start of a new list and after rebase_starts. Below zero and far
+		/// enough from it that the keys of a list of any int size fit into an
+		/// int.
+		static constexpr int base_start = -(1 << 29);
+
+		/// @brief Moves every key back so that front_start is base_start again,
+		/// once pushes and pops at the front have taken it more than 2^29 away.
+		/// Costs O(chunks) at most every 2^29 elements.
+		void rebase_starts() noexcept {
+			int offset = front_start - base_start;
+			if (offset >= base_start && offset <= -base_start) return;
+			for (int& start : chunk_start)
+				start -= offset;
+			front_start = base_start;
+		};
+
+		/// @brief Returns the directory slot of the chunk holding the element with
+		/// the given key and sets start to the start of that chunk. The starts on
+		/// either side of the pending shift are searched separately, each as they
+		/// are stored.
+		int chunk_of(int key, int& start) const noexcept {
+			const int* starts = chunk_start.data();
+			if constexpr (probing) {
+				std::atomic_ref(probe_data.lookups).fetch_add(1, std::memory_order_relaxed);
+				if (pending_shift != 0 || starts[chunk_count - 1] - starts[0] != (chunk_count - 1) * N)
+					std::atomic_ref(probe_data.searches).fetch_add(1, std::memory_order_relaxed);
+			}
+			int index;
+			if (pending_shift == 0) [[likely]] {
+				index = chunk_of(chunk_start, key);
+				start = starts[index];
+			}
+			else if (key < starts[pending_from] + pending_shift) {
+				index = static_cast<int>(std::upper_bound(starts, starts + pending_from, key) - starts) - 1;
+				start = starts[index];
+			}
+			else {
+				index = static_cast<int>(std::upper_bound(starts + pending_from, starts + chunk_count, key - pending_shift) - starts) - 1;
+				start = starts[index] + pending_shift;
+			}
+			return index;
 		};
 
-		friend bool operator<=(const ConstIterator<value_type>& lhs,
-			const ConstIterator<value_type>& rhs) {
-			return !(rhs._index > lhs._index);
+		/// @brief Returns the directory slot of the chunk holding position pos.
+		int chunk_index(int pos) const noexcept {
+			int start;
+			return chunk_of(front_start + pos, start);
 		};
 
-		friend bool operator>(const ConstIterator<value_type>& lhs,
-			const ConstIterator<value_type>& rhs) {
-			return rhs._index < lhs._index;
+		/// @brief Finds the chunk holding position pos and the offset inside it.
+		/// Position size() maps to the slot after the last element of the tail chunk.
+		void locate(int pos, ChunkNode*& node, int& offset) const noexcept {
+			if (pos == list_size) {
+				node = last;
+				offset = last != nullptr ? last->node_begin + last->node_size : 0;
+				return;
+			}
+			int key = front_start + pos;
+			int start;
+			node = directory[chunk_of(key, start)];
+			offset = key - start;
+		};
+
+		/// @brief Merges the chunk at slot index of the directory with the next one
+		/// if together they fill at most three quarters of a chunk. The slack keeps
+		/// a chunk that was just split from being merged back by the next erase.
+		/// @return true if the chunks were merged
+		bool try_merge(int index) {
+			if (index < 0 || index + 1 >= chunk_count) return false;
+			ChunkNode* left = directory[index];
+			ChunkNode* right = directory[index + 1];
+			if (left->node_size + right->node_size > N - N / 4) return false;
+
+			left = own(index);
+			right = own(index + 1);
+			if (left->node_begin + left->node_size + right->node_size > N)
+				pack(left);
+			relocate(right, 0, left, left->node_size, right->node_size);
+			left->node_size += right->node_size;
+			right->node_size = 0;
+			erase_chunks(index + 1, 1);
+			return true;
 		};
 
-		friend bool operator>=(const ConstIterator<value_type>& lhs,
-			const ConstIterator<value_type>& rhs) {
-			return !(lhs._index < rhs._index);
+		/// @brief Tops up the chunk at slot index of the directory with elements
+		/// from the front of the next chunk, at most limit of them, and releases the
+		/// next chunk if that empties it.
+		/// @return Number of elements moved, the ones left in the next chunk
+		/// included
+		int top_up(int index, int limit) {
+			ChunkNode* left = own(index);
+			ChunkNode* right = own(index + 1);
+			int n = std::min({ N - left->node_size, right->node_size, limit });
+			if (left->node_begin + left->node_size + n > N)
+				pack(left);
+			relocate(right, 0, left, left->node_size, n);
+			left->node_size += n;
+			right->node_size -= n;
+			if (right->node_size == 0) {
+				erase_chunks(index + 1, 1);
+				return n;
+			}
+			relocate(right, n, right, 0, right->node_size);
+			chunk_start[index + 1] += n;
+			return n + right->node_size;
+		};
+
+		/// @brief Incremental compaction, called after inserts and erases in the
+		/// middle. While the chunks are less than policy.min_fill percent occupied,
+		/// chunks are topped up from their next chunk, continuing from
+		/// compact_cursor, until about policy.compact_step elements were moved.
+		void compact_step() {
+			if constexpr (policy.min_fill > 0) {
+				if (list_size * 100LL >= static_cast<long long>(policy.min_fill) * chunk_count * N) return;
+				int budget = policy.compact_step > 0 ? policy.compact_step : N;
+				int index = compact_cursor + 1 < chunk_count ? compact_cursor : 0;
+				while (budget > 0 && index + 1 < chunk_count) {
+					if (directory[index]->node_size == N)
+						index++;
+					else
+						budget -= top_up(index, budget);
+					budget--;
+				}
+				compact_cursor = index;
+			}
 		};
-	};
 
-	template <typename T, int N, typename Allocator = Allocator<T>>
-	class ChunkList : public IChunkList<T> {
-		class ChunkNode {
-		public:
-			T* list = nullptr;
-			ChunkNode* prev = nullptr;
-			ChunkNode* next = nullptr;
-			int node_size = 0;
-			Allocator allocator;
-			ChunkNode(const Allocator& alloc = Allocator()) : allocator(alloc) {
-				list = allocator.allocate(N);
+		/// @brief Inserts count elements before position index. Each element is
+		/// constructed in place by build(node, slot). Only the chunk holding index is
+		/// touched: the elements are shifted inside it when they fit, otherwise it
+		/// is split and the overflow goes to new chunks linked right after it.
+		/// @return Iterator pointing to the first inserted element
+		template <class Build>
+		iterator insert_block(int index, int count, Build build) {
+			if (count <= 0) return iterator(this, index);
+			[[maybe_unused]] auto scope = probe_call(&chunk_probe::inserts);
+			if (index == list_size) {
+				for (int i = 0; i < count; i++) {
+					ChunkNode* tail = last;
+					if (tail == nullptr || tail->node_begin + tail->node_size == N)
+						tail = append_chunk();
+					else if (shared)
+						tail = own(chunk_count - 1);
+					try {
+						build(tail, tail->node_size);
+					}
+					catch (...) {
+						if (tail->node_size == 0)
+							remove_last_chunk();
+						throw;
+					}
+					tail->node_size++;
+					list_size++;
+				}
+				return iterator(this, index);
 			}
 
-			ChunkNode(ChunkNode *other)
-			{
-				list = allocator.allocate(N);
-				for (size_type i = 0; i < N; i++)
-				{
-					list[i] = other->list[i];
+			int chunk = chunk_index(index);
+			ChunkNode* node = own(chunk);
+			int offset = front_start + index - start_of(chunk) - node->node_begin;
+
+			if (node->node_size + count <= N) {
+				open_gap(node, offset, count);
+				int built = 0;
+				try {
+					for (; built < count; built++) build(node, offset + built);
+				}
+				catch (...) {
+					destroy(node, offset, offset + built);
+					relocate(node, offset + count, node, offset, node->node_size - offset);
+					throw;
 				}
-				node_size = other->node_size;
+				node->node_size += count;
+				list_size += count;
+				shift_starts(chunk + 1, count);
+				return iterator(this, index);
 			}
+
+			// The old elements of the chunk and the new ones are spread evenly over
+			// as few chunks as possible. Elements of the chunk past its share are
+			// parked in a spare chunk first, so nothing is moved twice.
+			int total = node->node_size + count;
+			int chunks = (total + N - 1) / N;
+			int share = total / chunks + (total % chunks > 0 ? 1 : 0);
+			int cut = std::min(offset, share);
+			pack(node);
+			ChunkNode* spare = create_node();
+			spare->node_size = node->node_size - cut;
+			relocate(node, cut, spare, 0, spare->node_size);
+			node->node_size = cut;
+
+			std::vector<ChunkNode*> added;
+			ChunkNode* cur = node;
+			auto reserve_slot = [&]() {
+				if (cur->node_size == share) {
+					cur = create_node();
+					added.push_back(cur);
+					share = total / chunks + (static_cast<int>(added.size()) < total % chunks ? 1 : 0);
+				}
+			};
+			int before = offset - cut;
+			try {
+				added.reserve(chunks - 1);
+				for (int i = 0; i < before; i++) {
+					reserve_slot();
+					construct(cur, cur->node_size, std::move(spare->data()[i]));
+					cur->node_size++;
+				}
+				for (int i = 0; i < count; i++) {
+					reserve_slot();
+					build(cur, cur->node_size);
+					cur->node_size++;
+				}
+				for (int i = before; i < spare->node_size; i++) {
+					reserve_slot();
+					construct(cur, cur->node_size, std::move(spare->data()[i]));
+					cur->node_size++;
+				}
+			}
+			catch (...) {
+				// Walks the elements placed so far in order: the parked ones go back
+				// to their slots in spare, the new ones are destroyed. Then spare is
+				// moved back behind the cut.
+				int placed = 0;
+				auto undo = [&](ChunkNode* chunk, int from) {
+					for (int i = from; i < chunk->node_size; i++, placed++) {
+						int slot = placed < before ? placed : placed - count;
+						if (placed < before || placed >= before + count) {
+							alloc_traits::destroy(allocator, spare->data() + slot);
+							construct(spare, slot, std::move(chunk->data()[i]));
+						}
+					}
+					destroy(chunk, from, chunk->node_size);
+					chunk->node_size = from;
+				};
+				undo(node, cut);
+				for (ChunkNode* chunk : added) {
+					undo(chunk, 0);
+					destroy_node(chunk);
+				}
+				relocate(spare, 0, node, cut, spare->node_size);
+				node->node_size += spare->node_size;
+				spare->node_size = 0;
+				destroy_node(spare);
+				throw;
+			}
+			tally(&chunk_probe::element_moves, spare->node_size);
+			destroy_node(spare);
+
+			list_size += count;
+			if (!added.empty())
+				link_chunks(added.data(), static_cast<int>(added.size()), node, chunk + 1);
+			shift_starts(chunk + 1 + static_cast<int>(added.size()), count);
+			compact_step();
+			return iterator(this, index);
+		};
+
+		/// @brief Removes count elements starting at position index. Only the first
+		/// and the last touched chunks are shifted, chunks covered by the range are
+		/// released as a whole and the chunks around the gap are merged when they
+		/// fit into one.
+		void erase_block(int index, int count) {
+			if (count <= 0) return;
+			[[maybe_unused]] auto scope = probe_call(&chunk_probe::erases);
+
+			int chunk = chunk_index(index);
+			ChunkNode* node = own(chunk);
+			int offset = front_start + index - start_of(chunk) - node->node_begin;
+			int n = std::min(count, node->node_size - offset);
+			int left = count - n;
+			int to = chunk + 1;
+			while (left > 0 && directory[to]->node_size <= left)
+				left -= directory[to++]->node_size;
+			// Copying a shared chunk may throw, so it happens before anything is
+			// destroyed.
+			ChunkNode* tail = left > 0 ? own(to) : nullptr;
+
+			close_gap(node, offset, n);
+			int from = node->node_size == 0 ? chunk : chunk + 1;
+			if (left > 0)
+				close_gap(tail, 0, left);
+
+			erase_chunks(from, to - from);
+			list_size -= count;
+			if (left > 0) {
+				shift_starts(from + 1, -count);
+				update_starts(from, from + 1);
+			}
+			else {
+				shift_starts(from, -count);
+			}
+
+			if (!try_merge(from - 1)) {
+				try_merge(from);
+				try_merge(from - 2);
+			}
+			compact_step();
 		};
-	protected:
-		ChunkNode* first = nullptr;
-		int list_size = 0;
-	public:
 
-		using value_type = T;
-		using allocator_type = Allocator;
-		using size_type = std::size_t;
-		using difference_type = std::ptrdiff_t;
-		using reference = value_type&;
-		using const_reference = const value_type&;
-		using pointer = value_type*;
-		using const_pointer = const pointer;
-		using iterator = Iterator<value_type>;
-		using const_iterator = ConstIterator<value_type>;
+	public:
 
 		/// @brief Default constructor. Constructs an empty container with a
 		/// default-constructed allocator.
-		ChunkList() : first(new ChunkNode()) {};
+		ChunkList() = default;
 
-		/// @brief Constructs an empty container with the given allocator
+		/// @brief Constructs an empty container with the given allocator. The
+		/// constructors that build elements delegate to it, so ~ChunkList frees
+		/// what they built if an element throws.
 		/// @param alloc allocator to use for all memory allocations of this container
-		/// s
-		/*explicit ChunkList(const Allocator& alloc);*/
+		explicit ChunkList(const Allocator& alloc) : allocator(alloc) {};
 
 		/// @brief Constructs the container with count copies of elements with value
 		/// and with the given allocator
 		/// @param count the size of the container
 		/// @param value the value to initialize elements of the container with
 		/// @param alloc allocator to use for all memory allocations of this container
-		ChunkList(size_type count, const T& value = T(), const Allocator& alloc = Allocator())
-			: first(new ChunkNode())
+		ChunkList(size_type count, const T& value, const Allocator& alloc = Allocator())
+			: ChunkList(alloc)
 		{
-			for (size_type i = 0; i < count; i++)
-				push_back(value);
+			append_fill(count, value);
 		};
 
 		/// @brief Constructs the container with count default-inserted instances of
@@ -345,9 +1904,9 @@ namespace fefu_laboratory_two
 		/// @param count the size of the container
 		/// @param alloc allocator to use for all memory allocations of this container
 		explicit ChunkList(size_type count, const Allocator& alloc = Allocator())
-			: first(new ChunkNode())
+			: ChunkList(alloc)
 		{
-			for (size_type i = 0; i < count; i++) push_back(value_type());
+			append_default(count);
 		};
 
 		/// @brief Constructs the container with the contents of the range [first,
@@ -355,32 +1914,23 @@ namespace fefu_laboratory_two
 		/// @tparam InputIt Input Iterator
 		/// @param first, last 	the range to copy the elements from
 		/// @param alloc allocator to use for all memory allocations of this container
-		template <class InputIt>
-		ChunkList(InputIt first, InputIt last, const Allocator& alloc = Allocator()) {
-			if (first == last) return;
-			this->first = new ChunkNode(alloc);
-
-			auto it = first;
-
-			for (; it != last; ++it) push_back(*it);
+		template <class InputIt, typename = std::enable_if_t<!std::is_integral_v<InputIt>>>
+		ChunkList(InputIt first, InputIt last, const Allocator& alloc = Allocator())
+			: ChunkList(alloc) {
+			assignIt(first, last);
 		};
 
 		/// @brief Copy constructor. Constructs the container with the copy of the
 		/// contents of other.
 		/// @param other another container to be used as source to initialize the
 		/// elements of the container with
-		ChunkList(const ChunkList& other) {
-
-			ChunkNode* otherNode = other.first;
-			if (otherNode == nullptr) return;
-			first = new ChunkNode(otherNode);
-			ChunkNode* node = first;
+		ChunkList(const ChunkList& other)
+			: ChunkList(alloc_traits::select_on_container_copy_construction(other.allocator)) {
 
-			while (otherNode->next != nullptr)
+			for (ChunkNode* otherNode = other.first; otherNode != nullptr; otherNode = otherNode->next)
 			{
-				node->next = new ChunkNode(otherNode->next);
-				node = node->next;
-				otherNode = otherNode->next;
+				ChunkNode* node = create_node(otherNode);
+				link_chunks(&node, 1, last, chunk_count);
 			}
 
 			list_size = other.list_size;
@@ -391,13 +1941,14 @@ namespace fefu_laboratory_two
 		/// @param other another container to be used as source to initialize the
 		/// elements of the container with
 		/// @param alloc allocator to use for all memory allocations of this container
-		ChunkList(const ChunkList& other, const Allocator& alloc) {
-			this = ChunkList(other);
-			ChunkNode* tmp = this->first;
-			while (tmp != nullptr) {
-				tmp->allocator = alloc;
-				tmp = tmp->next;
+		ChunkList(const ChunkList& other, const Allocator& alloc) : ChunkList(alloc) {
+			for (ChunkNode* otherNode = other.first; otherNode != nullptr; otherNode = otherNode->next)
+			{
+				ChunkNode* node = create_node(otherNode);
+				link_chunks(&node, 1, last, chunk_count);
 			}
+
+			list_size = other.list_size;
 		};
 
 		/**
@@ -410,10 +1961,8 @@ namespace fefu_laboratory_two
 		 * @param other another container to be used as source to initialize the
 		 * elements of the container with
 		 */
-		ChunkList(ChunkList&& other) {
-			first = std::move(other.first);
-			list_size = std::move(other.list_size);
-			other.clear();
+		ChunkList(ChunkList&& other) noexcept : allocator(other.allocator) {
+			steal(other);
 		};
 
 		/**
@@ -426,12 +1975,13 @@ namespace fefu_laboratory_two
 		 * elements of the container with
 		 * @param alloc allocator to use for all memory allocations of this container
 		 */
-		ChunkList(ChunkList&& other, const Allocator& alloc) {
-			this = ChunkList(other);
-			ChunkNode* tmp = first;
-			while (tmp != nullptr) {
-				tmp->allocator = alloc;
-				tmp = tmp->next;
+		ChunkList(ChunkList&& other, const Allocator& alloc) : ChunkList(alloc) {
+			if (allocator == other.allocator) {
+				steal(other);
+			}
+			else {
+				append_copy(std::make_move_iterator(other.begin()), other.size());
+				other.clear();
 			}
 		};
 
@@ -440,28 +1990,39 @@ namespace fefu_laboratory_two
 		/// @param init initializer list to initialize the elements of the container
 		/// with
 		/// @param alloc allocator to use for all memory allocations of this container
-		ChunkList(std::initializer_list<T> init, const Allocator& alloc = Allocator()) {
-			if (init.size() == 0) return;
-			first = new ChunkNode(alloc);
-
-			auto it = init.begin();
-
-			for (; it != init.end(); ++it)
-				push_back(*it);
+		ChunkList(std::initializer_list<T> init, const Allocator& alloc = Allocator())
+			: ChunkList(alloc) {
+			append_copy(init.begin(), init.size());
 		};
 
 		/// @brief Destructs the ChunkList.
-		~ChunkList() override {
+		~ChunkList() {
 			clear();
 		};
 
 		/// @brief Copy assignment operator. Replaces the contents with a copy of the
-		/// contents of other.
+		/// contents of other. If copying T cannot throw, the chunks and elements
+		/// already held are reused; otherwise a copy is built and swapped in, so
+		/// the list is unchanged if a copy throws.
 		/// @param other another container to use as data source
 		/// @return *this
 		ChunkList& operator=(const ChunkList& other) {
-			(this) = new ChunkList(other);
-			return (*this);
+			if (this == &other)
+				return *this;
+			if constexpr (alloc_traits::propagate_on_container_copy_assignment::value) {
+				if (allocator != other.allocator) {
+					clear();
+					allocator = other.allocator;
+				}
+			}
+			if constexpr (std::is_nothrow_copy_assignable_v<T> && std::is_nothrow_copy_constructible_v<T>) {
+				assign_reusing(other);
+			}
+			else {
+				ChunkList copy(other, allocator);
+				swap(copy);
+			}
+			return *this;
 		};
 
 		/**
@@ -474,13 +2035,22 @@ namespace fefu_laboratory_two
 		 * @param other another container to use as data source
 		 * @return *this
 		 */
-		ChunkList& operator=(ChunkList&& other) {
+		ChunkList& operator=(ChunkList&& other) noexcept(
+			alloc_traits::propagate_on_container_move_assignment::value || alloc_traits::is_always_equal::value) {
 			if (this == &other)
-				return this;
-			first = std::move(other.first);
-			list_size = std::move(other.list_size);
-			other.clear();
-
+				return *this;
+			clear();
+			if constexpr (alloc_traits::propagate_on_container_move_assignment::value) {
+				allocator = other.allocator;
+				steal(other);
+			}
+			else if (allocator == other.allocator) {
+				steal(other);
+			}
+			else {
+				append_copy(std::make_move_iterator(other.begin()), other.size());
+				other.clear();
+			}
 			return *this;
 		};
 
@@ -489,9 +2059,7 @@ namespace fefu_laboratory_two
 		/// @param ilist
 		/// @return this
 		ChunkList& operator=(std::initializer_list<T> ilist) {
-			auto it = ilist.begin();
-
-			for (; it != ilist.end(); ++it) push_back(*it);
+			assign(ilist);
 			return *this;
 		};
 
@@ -500,8 +2068,7 @@ namespace fefu_laboratory_two
 		/// @param value
 		void assign(size_type count, const T& value) {
 			clear();
-			for (size_type i = 0; i < count; i++) push_back(value);
-			list_size = count;
+			append_fill(count, value);
 		};
 
 		/// @brief Replaces the contents with copies of those in the range [first,
@@ -511,37 +2078,31 @@ namespace fefu_laboratory_two
 		/// @param last
 		template <class InputIt>
 		void assignIt(InputIt first, InputIt last) {
-			if (first == last) return;
 			clear();
-
-			auto it = first;
-
-			for (; it != last; ++it) push_back(*it);
+			if constexpr (std::forward_iterator<InputIt>)
+				append_copy(first, static_cast<size_type>(std::distance(first, last)));
+			else
+				for (; first != last; ++first) emplace_back(*first);
 		};
 
 		/// @brief Replaces the contents with the elements from the initializer list
 		/// ilis
 		/// @param ilist
 		void assign(std::initializer_list<T> ilist) {
-			if (ilist.size() == 0) return;
 			clear();
-
-			auto it = ilist.begin();
-
-			for (; it != ilist.end(); ++it) push_back(*it);
+			append_copy(ilist.begin(), ilist.size());
 		};
 
 		/// @brief Returns the allocator associated with the container.
 		/// @return The associated allocator.
 		allocator_type get_allocator() const noexcept {
-			return first->allocator;
+			return allocator;
 		};
 
-		ChunkNode* last_chunk() {
-			ChunkNode* tmp = first;
-			while (tmp->next != nullptr)
-				tmp = tmp->next;
-			return tmp;
+		/// @brief Returns the tail chunk in constant time.
+		/// @return Pointer to the last chunk, nullptr if there are no chunks.
+		ChunkNode* last_chunk() const noexcept {
+			return last;
 		}
 
 		/// ELEMENT ACCESS
@@ -552,17 +2113,10 @@ namespace fefu_laboratory_two
 		/// @param pos position of the element to return
 		/// @return Reference to the requested element.
 		/// @throw std::out_of_range
-		reference at(size_type pos) override {
-			int chunk_index = pos / N;
-			int elemnt_index = pos % N;
-			if (pos >= max_size() || pos < 0) throw std::out_of_range("Out of range");
+		reference at(size_type pos) {
+			if (pos >= size()) throw std::out_of_range("Out of range");
 
-			ChunkNode* tmp = first;
-			while (chunk_index > 0) {
-				tmp = tmp->next;
-				chunk_index--;
-			}
-			return tmp->list[elemnt_index];
+			return (*this)[pos];
 		};
 
 		/// @brief Returns a const reference to the element at specified location pos,
@@ -572,25 +2126,21 @@ namespace fefu_laboratory_two
 		/// @return Const Reference to the requested element.
 		/// @throw std::out_of_range
 		const_reference at(size_type pos) const {
-			int chunk_index = pos / N;
-			int elemnt_index = pos % N;
-			if (pos >= max_size() || pos < 0)
+			if (pos >= size())
 				throw std::out_of_range("Out of range");
 
-			ChunkNode* tmp = first;
-			while (chunk_index > 0) {
-				tmp = tmp->next;
-				chunk_index--;
-			}
-			return tmp->list[elemnt_index];
+			return (*this)[pos];
 		};
 
 		/// @brief Returns a reference to the element at specified location pos. No
 		/// bounds checking is performed.
 		/// @param pos position of the element to return
 		/// @return Reference to the requested element.
-		reference operator[](size_type pos) override {
-			return at(pos);
+		reference operator[](size_type pos) {
+			int key = front_start + static_cast<int>(pos);
+			int start;
+			int index = chunk_of(key, start);
+			return own(index)->list[key - start];
 		};
 
 		/// @brief Returns a const reference to the element at specified location pos.
@@ -598,7 +2148,10 @@ namespace fefu_laboratory_two
 		/// @param pos position of the element to return
 		/// @return Const Reference to the requested element.
 		const_reference operator[](size_type pos) const {
-			return at(pos);
+			int key = front_start + static_cast<int>(pos);
+			int start;
+			int index = chunk_of(key, start);
+			return directory[index]->list[key - start];
 		};
 
 		/// @brief Returns a reference to the first element in the container.
@@ -607,7 +2160,7 @@ namespace fefu_laboratory_two
 		reference front() {
 			if (!list_size) throw std::logic_error("Empty container");
 
-			return first->list[0];
+			return own(0)->data()[0];
 		};
 
 		/// @brief Returns a const reference to the first element in the container.
@@ -615,7 +2168,7 @@ namespace fefu_laboratory_two
 		/// @return Const reference to the first element
 		const_reference front() const {
 			if (!list_size) throw std::logic_error("Empty container");
-			return first->list[0];
+			return first->data()[0];
 		};
 
 		/// @brief Returns a reference to the last element in the container.
@@ -624,10 +2177,8 @@ namespace fefu_laboratory_two
 		reference back() {
 			if (!list_size) throw std::logic_error("Empty container");
 
-			ChunkNode* tmp = last_chunk();
-			while (tmp->next != nullptr) tmp = tmp->next;
-
-			return tmp->list[tmp->node_size - 1];
+			ChunkNode* tail = own(chunk_count - 1);
+			return tail->data()[tail->node_size - 1];
 		};
 
 		/// @brief Returns a const reference to the last element in the container.
@@ -636,8 +2187,7 @@ namespace fefu_laboratory_two
 		const_reference back() const {
 			if (!list_size) throw std::logic_error("Empty");
 
-			ChunkNode* tmp = last_chunk();
-			return tmp->list[tmp->node_size - 1];
+			return last->data()[last->node_size - 1];
 		};
 
 		/// ITERATORS
@@ -645,12 +2195,15 @@ namespace fefu_laboratory_two
 		/// @brief Returns an iterator to the first element of the ChunkList.
 		/// If the ChunkList is empty, the returned iterator will be equal to end().
 		/// @return Iterator to the first element.
-		iterator begin() noexcept { return Iterator<T>(this, 0, &at(0)); };
+		iterator begin() {
+			own_all();
+			return iterator(this, 0);
+		};
 
 		/// @brief Returns an iterator to the first element of the ChunkList.
 		/// If the ChunkList is empty, the returned iterator will be equal to end().
 		/// @return Iterator to the first element.
-		const_iterator begin() const noexcept { return ConstIterator<T>(this, 0, &at(0)); };
+		const_iterator begin() const noexcept { return const_iterator(this, 0); };
 
 		/// @brief Same to begin()
 		const_iterator cbegin() const noexcept { return begin(); };
@@ -659,17 +2212,80 @@ namespace fefu_laboratory_two
 		/// the ChunkList. This element acts as a placeholder; attempting to access it
 		/// results in undefined behavior.
 		/// @return Iterator to the element following the last element.
-		iterator end() noexcept { return Iterator<T>(); };
+		iterator end() {
+			own_all();
+			return iterator(this, list_size);
+		};
 
 		/// @brief Returns an constant iterator to the element following the last
 		/// element of the ChunkList. This element acts as a placeholder; attempting to
 		/// access it results in undefined behavior.
 		/// @return Constant Iterator to the element following the last element.
-		const_iterator end() const noexcept { return ConstIterator<T>(); };
+		const_iterator end() const noexcept { return const_iterator(this, list_size); };
 
 		/// @brief Same to end()
 		const_iterator cend() const noexcept { return end(); };
 
+		/// @brief Returns a reverse iterator to the last element of the ChunkList.
+		/// Reverse traversal steps through the prev links of the chunks.
+		/// @return Reverse iterator to the first element of the reversed ChunkList.
+		reverse_iterator rbegin() { return reverse_iterator(end()); };
+
+		/// @brief Returns a constant reverse iterator to the last element of the
+		/// ChunkList.
+		/// @return Reverse iterator to the first element of the reversed ChunkList.
+		const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator(end()); };
+
+		/// @brief Same to rbegin()
+		const_reverse_iterator crbegin() const noexcept { return rbegin(); };
+
+		/// @brief Returns a reverse iterator to the element preceding the first
+		/// element of the ChunkList. It acts as a placeholder.
+		/// @return Reverse iterator to the element following the last element of
+		/// the reversed ChunkList.
+		reverse_iterator rend() { return reverse_iterator(begin()); };
+
+		/// @brief Returns a constant reverse iterator to the element preceding the
+		/// first element of the ChunkList. It acts as a placeholder.
+		/// @return Reverse iterator to the element following the last element of
+		/// the reversed ChunkList.
+		const_reverse_iterator rend() const noexcept { return const_reverse_iterator(begin()); };
+
+		/// @brief Same to rend()
+		const_reverse_iterator crend() const noexcept { return rend(); };
+
+		/// @brief Returns the chunks of the ChunkList in order, each as a
+		/// std::span over its elements. Empty chunks never appear.
+		/// @return Random access range of spans.
+		chunk_range chunks() {
+			own_all();
+			return chunk_range(directory.data(), chunk_start.data(), front_start, chunk_count, pending_from, pending_shift);
+		};
+
+		/// @brief Returns the chunks of the ChunkList in order, each as a
+		/// std::span over its constant elements.
+		/// @return Random access range of spans.
+		const_chunk_range chunks() const noexcept {
+			return const_chunk_range(directory.data(), chunk_start.data(), front_start, chunk_count, pending_from, pending_shift);
+		};
+
+		/// @brief Returns a read-only view of the current contents that shares the
+		/// chunks instead of copying them. Costs O(chunks). Later writes to the
+		/// list copy a shared chunk first: push and pop at either end, operator[],
+		/// at, front, back, resize, insert, emplace and erase copy only the chunks
+		/// they write; the mutable begin, end and chunks copy every chunk still
+		/// shared, since their iterators and spans can write anywhere. The
+		/// iterator returned by insert, emplace or erase may write only the
+		/// element it points to while the snapshot lives. Mutable iterators,
+		/// references and spans taken before the snapshot must not be written
+		/// through after it.
+		/// @return Snapshot of the list.
+		snapshot_type snapshot() requires std::is_copy_constructible_v<T> {
+			settle_starts();
+			shared = true;
+			return snapshot_type(*this);
+		};
+
 		/// CAPACITY
 
 		/// @brief Checks if the container has no elements
@@ -678,27 +2294,109 @@ namespace fefu_laboratory_two
 
 		/// @brief Returns the number of elements in the container
 		/// @return The number of elements in the container.
-		size_type size() const noexcept override { return list_size; };
+		size_type size() const noexcept { return list_size; };
 
 		/// @brief Returns the maximum number of elements the container is able to
-		/// hold due to system or library implementation limitations
+		/// hold due to system or library implementation limitations. Positions
+		/// and keys are ints, which limits a list to less than 2^30 elements.
 		/// @return Maximum number of elements.
 		size_type max_size() const noexcept {
-			int r = list_size % N;
-			return (r == 0 ? list_size : list_size + N - r);
+			node_allocator node_alloc(allocator);
+			size_type chunks = node_traits::max_size(node_alloc);
+			size_type limit = std::numeric_limits<int>::max() / 2;
+			return chunks < limit / N ? chunks * N : limit;
+		};
+
+		/// @brief Returns the number of element slots of the allocated chunks,
+		/// size() of which hold elements
+		/// @return Capacity of the chunks.
+		size_type capacity() const noexcept { return static_cast<size_type>(chunk_count) * N; };
+
+		/// @brief Returns the memory use and chunk occupancy of the list. The fill
+		/// of every chunk is read from the chunk starts, not from the chunks, so it
+		/// costs a pass over one int per chunk and suits periodic metrics export.
+		/// Chunks shared with snapshots are counted as held by the list.
+		/// @return Statistics of the list.
+		chunk_stats stats() const noexcept {
+			chunk_stats result;
+			result.size = list_size;
+			result.chunks = chunk_count;
+			result.capacity = capacity();
+			result.wasted_slots = result.capacity - result.size;
+			result.chunk_bytes = chunk_count * sizeof(ChunkNode);
+			result.directory_bytes = directory.slots() * sizeof(ChunkNode*) + chunk_start.slots() * sizeof(int);
+			result.object_bytes = sizeof(ChunkList);
+			result.allocated_bytes = result.chunk_bytes + result.directory_bytes + result.object_bytes;
+			int end = front_start + list_size;
+			for (int i = chunk_count - 1; i >= 0; i--) {
+				int begin = std::max(start_of(i), front_start);
+				int size = end - begin;
+				result.fill[size > 0 ? static_cast<std::size_t>((size * 8LL - 1) / N) : 0]++;
+				end = begin;
+			}
+			result.chunk_allocations = chunk_allocations;
+			result.chunk_frees = chunk_frees;
+			return result;
 		};
 
+		/// @brief Returns the counters recorded by the hot paths of an
+		/// instrumented list, e.g. ChunkList<T, chunk_policy{ .probe =
+		/// probe_level::latency }>. Lists whose policy leaves probe off have no
+		/// probe and pay nothing for the hooks.
+		/// @return Counters since construction or the last reset_probe().
+		const chunk_probe& probe() const noexcept requires probing { return probe_data; };
+
+		/// @brief Zeroes the counters of an instrumented list
+		void reset_probe() noexcept requires probing { probe_data = chunk_probe(); };
+
 		/// @brief Requests the removal of unused capacity.
 		/// It is a non-binding request to reduce the memory usage without changing
 		/// the size of the sequence. All iterators and references are invalidated.
 		/// Past-the-end iterator is also invalidated.
+		/// The chunks are compacted and the chunk directory gives back its spare
+		/// capacity.
+		/// Complexity: linear in size().
 		void shrink_to_fit() {
-			ChunkNode* tmp = last_chunk();
-			while (tmp->node_size == 0)
-			{
-				tmp = tmp->prev;
-				tmp->next = nullptr;
+			compact();
+			directory.shrink_to_fit();
+			chunk_start.shrink_to_fit();
+		};
+
+		/// @brief Moves the elements into as few chunks as possible, every chunk
+		/// full but the tail, and gives the chunks left empty back to the
+		/// allocator. Erases and inserts in the middle leave partly filled chunks
+		/// behind, which cost memory and make lookups search the directory.
+		/// The order of the elements is kept. All iterators and references are
+		/// invalidated.
+		/// Complexity: linear in size().
+		void compact() {
+			if (chunk_count == 0) return;
+			own_all();
+			settle_starts();
+			pack(first);
+			int fill = 0;
+			for (int i = 1; i < chunk_count; i++) {
+				ChunkNode* src = directory[i];
+				int taken = 0;
+				while (taken < src->node_size) {
+					if (directory[fill]->node_size == N)
+						fill++;
+					if (fill == i) {
+						if (taken > 0)
+							relocate(src, taken, src, 0, src->node_size - taken);
+						break;
+					}
+					ChunkNode* dst = directory[fill];
+					int n = std::min(N - dst->node_size, src->node_size - taken);
+					relocate(src, taken, dst, dst->node_size, n);
+					dst->node_size += n;
+					taken += n;
+				}
+				src->node_size -= taken;
 			}
+			int kept = list_size > 0 ? fill + 1 : 0;
+			erase_chunks(kept, chunk_count - kept);
+			update_starts(0, chunk_count);
 		};
 
 		/// MODIFIERS
@@ -711,47 +2409,29 @@ namespace fefu_laboratory_two
 			while (cur != nullptr) {
 				ChunkNode* tmp = cur;
 				cur = cur->next;
-				delete tmp;
+				destroy_node(tmp);
 			}
 			list_size = 0;
+			chunk_count = 0;
+			shared = false;
+			pending_shift = 0;
 			first = nullptr;
+			last = nullptr;
+			directory.clear();
+			chunk_start.clear();
 		};
 
-		/// @brief Shifts all elements from pos to end to the right, increases size to fit all
-		void shift_right(const_iterator pos) 
-		{
-			push_back(value_type());
-			iterator it = iterator(this, list_size-1, &at(list_size - 1));
-
-			while (true)
-			{
-				*it = *(it - 1);
-				it--;
-				if (it == pos) return;
-			}
-		}
-
-		void shift_left(const_iterator pos)
-		{
-			iterator it = iterator(this, pos.index(), &at(pos.index()));
-			while (true)
-			{
-				*it = *(it + 1);
-				it++;
-				if (it.index() == list_size - 1) break;
-			}
-			list_size--;
-		}
-
 		/// @brief Inserts value before pos.
 		/// @param pos iterator before which the content will be inserted.
 		/// @param value element value to insert
 		/// @return Iterator pointing to the inserted value.
 		iterator insert(const_iterator pos, const value_type& value) {
-			shift_right(pos);
-			iterator it = iterator(this, pos.index(), &at(pos.index()));
-			(*it) = value;
-			return it;
+			if (pos.index() == list_size)
+				return insert_block(pos.index(), 1, [this, &value](ChunkNode* node, int slot) { construct(node, slot, value); });
+			// value may be an element of the list, which insert_block can move
+			// before it builds the new one.
+			value_type copy(value);
+			return insert_block(pos.index(), 1, [this, &copy](ChunkNode* node, int slot) { construct(node, slot, std::move(copy)); });
 		};
 
 		/// @brief Inserts value before pos.
@@ -759,10 +2439,7 @@ namespace fefu_laboratory_two
 		/// @param value element value to insert
 		/// @return Iterator pointing to the inserted value.
 		iterator insert(const_iterator pos, T&& value) {
-			shift_right(pos);
-			iterator it = iterator(this, pos.index(), &at(pos.index()));
-			(*it) = std::move(value);
-			return it;
+			return insert_block(pos.index(), 1, [this, &value](ChunkNode* node, int slot) { construct(node, slot, std::move(value)); });
 		};
 
 		/// @brief Inserts count copies of the value before pos.
@@ -773,13 +2450,10 @@ namespace fefu_laboratory_two
 		/// == 0.
 		iterator insert(const_iterator pos, size_type count, const T& value)
 		{
-			if (count == 0) return pos;
-
-			int index = pos.index();
-
-			for (int i = 0; i < count; i++) insert(pos, value);
-
-			return Iterator<T>(this, index, at(index));
+			if (pos.index() == list_size || count == 0)
+				return insert_block(pos.index(), static_cast<int>(count), [this, &value](ChunkNode* node, int slot) { construct(node, slot, value); });
+			const value_type copy(value);
+			return insert_block(pos.index(), static_cast<int>(count), [this, &copy](ChunkNode* node, int slot) { construct(node, slot, copy); });
 		};
 
 		/// @brief Inserts elements from range [first, last) before pos.
@@ -791,18 +2465,14 @@ namespace fefu_laboratory_two
 		/// == last.
 		template <class InputIt>
 		iterator insert(const_iterator pos, InputIt first, InputIt last) {
-			if (first == last) return pos;
-
-			int index = pos.index();
-			auto it = last - 1;
-			while (true)
-			{
-				insert(pos, *it);
-				if (it == first) break;
-				it--;
+			if constexpr (std::forward_iterator<InputIt>) {
+				int count = static_cast<int>(std::distance(first, last));
+				return insert_block(pos.index(), count, [this, &first](ChunkNode* node, int slot) { construct(node, slot, *first++); });
+			}
+			else {
+				std::vector<value_type> buffer(first, last);
+				return insert(pos, buffer.begin(), buffer.end());
 			}
-
-			return Iterator<T>(this, index, &at(index));
 		};
 
 		/// @brief Inserts elements from initializer list before pos.
@@ -812,18 +2482,7 @@ namespace fefu_laboratory_two
 		/// is empty.
 		iterator insert(const_iterator pos, std::initializer_list<T> ilist)
 		{
-			if (ilist.size() == 0) return pos;
-			int index = pos.index();
-			auto it = ilist.end() - 1;
-
-			while (true)
-			{
-				insert(pos, *it);
-				if (it == ilist.begin()) break;
-				it--;
-			}
-
-			return Iterator<T>(this, index, &at(index));
+			return insert(pos, ilist.begin(), ilist.end());
 		};
 
 
@@ -833,67 +2492,46 @@ namespace fefu_laboratory_two
 		/// @return terator pointing to the emplaced element.
 		template <class... Args>
 		iterator emplace(const_iterator pos, Args&&... args) {
-			auto data = { args... };
-			return insert(pos, data);
+			if (pos.index() == list_size)
+				return insert_block(pos.index(), 1, [this, &args...](ChunkNode* node, int slot) {
+					construct(node, slot, std::forward<Args>(args)...);
+				});
+			// args may refer to elements insert_block moves, so the element is
+			// built before and moved into its slot.
+			value_type value(std::forward<Args>(args)...);
+			return insert_block(pos.index(), 1, [this, &value](ChunkNode* node, int slot) { construct(node, slot, std::move(value)); });
 		};
 
 		/// @brief Removes the element at pos.
 		/// @param pos iterator to the element to remove
 		/// @return Iterator following the last removed element.
 		iterator erase(const_iterator pos) {
-			size_type index = pos.index();
-			shift_left(pos);
-			return Iterator<T>(this, index, &at(index));
+			erase_block(pos.index(), 1);
+			own_at(pos.index());
+			return iterator(this, pos.index());
 		};
 
 		/// @brief Removes the elements in the range [first, last).
 		/// @param first,last range of elements to remove
 		/// @return Iterator following the last removed element.
 		iterator erase(const_iterator first, const_iterator last) {
-			size_type diff = last.index() - first.index();
-
-			for (size_type i = 0; i < diff; i++)
-				erase(first + 1);
-
-			return Iterator<T>(this, first.index(), &at(first.index()));
+			erase_block(first.index(), last - first);
+			own_at(first.index());
+			return iterator(this, first.index());
 		};
 
 		/// @brief Appends the given element value to the end of the container.
 		/// The new element is initialized as a copy of value.
 		/// @param value the value of the element to append
 		void push_back(const T& value) {
-			if (first == nullptr)
-				first = new ChunkNode();
-
-			ChunkNode* tmp = last_chunk();
-			if (tmp->node_size == N)
-			{
-				tmp->next = new ChunkNode();
-				auto tmpPrev = tmp;
-				tmp = tmp->next;
-				tmp->prev = tmpPrev;
-			}
-			tmp->list[tmp->node_size] = value;
-			tmp->node_size++;
-			list_size++;
+			emplace_back(value);
 		};
 
 		/// @brief Appends the given element value to the end of the container.
 		/// Value is moved into the new element.
 		/// @param value the value of the element to append
 		void push_back(T&& value) {
-			if (first == nullptr)
-				first = new ChunkNode();
-
-			ChunkNode* tmp = last_chunk();
-			if (tmp->node_size == N)
-			{
-				tmp->next = new ChunkNode();
-				tmp = tmp->next;
-			}
-			tmp->list[tmp->node_size] = std::move(value);
-			tmp->node_size++;
-			list_size++;
+			emplace_back(std::move(value));
 		};
 
 		/// @brief Appends a new element to the end of the container.
@@ -901,51 +2539,87 @@ namespace fefu_laboratory_two
 		/// @return A reference to the inserted element.
 		template <class... Args>
 		reference emplace_back(Args&&... args) {
-			auto data = { args... };
-			auto it = data.begin();
-			for (; it != data.end(); it++)
-				push_back(*it);
-			return back();
+			ChunkNode* tmp = last;
+			if (tmp == nullptr || tmp->node_begin + tmp->node_size == N)
+				tmp = append_chunk();
+			else if (shared)
+				tmp = own(chunk_count - 1);
+
+			try {
+				construct(tmp, tmp->node_size, std::forward<Args>(args)...);
+			}
+			catch (...) {
+				if (tmp->node_size == 0)
+					remove_last_chunk();
+				throw;
+			}
+			list_size++;
+			return tmp->data()[tmp->node_size++];
 		};
 
 		/// @brief Removes the last element of the container.
 		void pop_back() {
+			own(chunk_count - 1);
 			this->list_size--;
-			ChunkNode* tmp = last_chunk();
-			tmp->node_size--;
+			last->node_size--;
+			destroy(last, last->node_size, last->node_size + 1);
+			if (last->node_size == 0)
+				remove_last_chunk();
 		};
 
 		/// @brief Prepends the given element value to the beginning of the container.
 		/// @param value the value of the element to prepend
 		void push_front(const T& value) {
-			insert(cbegin(), value);
+			emplace_front(value);
 		};
 
 		/// @brief Prepends the given element value to the beginning of the container.
 		/// @param value moved value of the element to prepend
 		void push_front(T&& value) {
-			insert(cbegin(), std::move(value));
+			emplace_front(std::move(value));
 		};
 
 		/// @brief Inserts a new element to the beginning of the container.
+		/// Amortized constant time: the element goes into the free slot in front
+		/// of the head chunk, or into a new head chunk that fills from the back.
 		/// @param ...args arguments to forward to the constructor of the element
 		/// @return A reference to the inserted element.
 		template <class... Args>
 		reference emplace_front(Args&&... args) {
-			auto data = { args... };
-			auto it = data.end() - 1;
-			while (true)
-			{
-				insert(cbegin(), *it);
-				if (it == data.begin()) break;
-				it--;
+			ChunkNode* head = first;
+			if (head == nullptr || head->node_begin == 0)
+				head = prepend_chunk();
+			else if (shared)
+				head = own(0);
+
+			try {
+				construct(head, -1, std::forward<Args>(args)...);
 			}
-			return back();
+			catch (...) {
+				if (head->node_size == 0)
+					erase_chunks(0, 1);
+				throw;
+			}
+			head->node_begin--;
+			head->node_size++;
+			front_start--;
+			list_size++;
+			rebase_starts();
+			return head->data()[0];
 		};
 
-		/// @brief Removes the first element of the container.
+		/// @brief Removes the first element of the container in constant time.
+		/// Only the head chunk changes, the free slot is left in front of it.
 		void pop_front() {
-			erase(cbegin());
+			ChunkNode* head = own(0);
+			destroy(head, 0, 1);
+			head->node_begin++;
+			head->node_size--;
+			front_start++;
+			list_size--;
+			if (head->node_size == 0)
+				erase_chunks(0, 1);
+			rebase_starts();
 		};
 
 		/// @brief Resizes the container to contain count elements.
@@ -954,13 +2628,10 @@ namespace fefu_laboratory_two
 		/// default-inserted elements are appended
 		/// @param count new size of the container
 		void resize(size_type count) {
-			if (count == list_size) return;
-			if (count < list_size)
-				while (list_size != count)
-					pop_back();
+			if (count < size())
+				erase_block(static_cast<int>(count), list_size - static_cast<int>(count));
 			else
-				while (list_size != count)
-					push_back(T());
+				append_default(count - size());
 		};
 
 		/// @brief Resizes the container to contain count elements.
@@ -970,13 +2641,10 @@ namespace fefu_laboratory_two
 		/// @param count new size of the container
 		/// @param value the value to initialize the new elements with
 		void resize(size_type count, const value_type& value) {
-			if (count == list_size) return;
-			if (count < list_size)
-				while (list_size != count)
-					pop_back();
+			if (count < size())
+				erase_block(static_cast<int>(count), list_size - static_cast<int>(count));
 			else
-				while (list_size != count)
-					push_back(value);
+				append_fill(count - size(), value);
 		};
 
 		/// @brief Exchanges the contents of the container with those of other.
@@ -984,78 +2652,55 @@ namespace fefu_laboratory_two
 		/// All iterators and references remain valid. The past-the-end iterator is
 		/// invalidated.
 		/// @param other container to exchange the contents with
-		void swap(ChunkList& other) {
-			ChunkNode* first_tmp;
-			int size_tmp;
-
-			first_tmp = other.first;
-			size_tmp = other.list_size;
-
-			other.first = first;
-			other.list_size = list_size;
-
-			first = first_tmp;
-			list_size = size_tmp;
+		void swap(ChunkList& other) noexcept {
+			std::swap(allocator, other.allocator);
+			std::swap(first, other.first);
+			std::swap(last, other.last);
+			std::swap(chunk_count, other.chunk_count);
+			std::swap(list_size, other.list_size);
+			std::swap(front_start, other.front_start);
+			std::swap(pending_from, other.pending_from);
+			std::swap(pending_shift, other.pending_shift);
+			std::swap(shared, other.shared);
+			directory.swap(other.directory);
+			chunk_start.swap(other.chunk_start);
 		};
 
 		/// COMPARISIONS
 
-		/// @brief Checks if the contents of lhs and rhs are equal
+		/// @brief Checks if the contents of lhs and rhs are equal. Both chunk
+		/// chains are walked in step and matching runs are compared at once, with
+		/// memcmp when T is an integer or pointer type, whose built-in == compares
+		/// exactly the bytes. Other types, enums included, may define their own ==.
 		/// @param lhs,rhs ChunkLists whose contents to compare
-		friend bool operator==(const ChunkList& lhs,
-			const ChunkList& rhs) {
+		friend bool operator==(const ChunkList& lhs, const ChunkList& rhs) {
 			if (lhs.list_size != rhs.list_size)
 				return false;
 
-			for (int i = 0; i < lhs.list_size; i++)
-				if (lhs.at(i) != rhs.at(i))
-					return false;
-
-			return true;
-		};
-
-		/// @brief Checks if the contents of lhs and rhs are not equal
-		/// @param lhs,rhs ChunkLists whose contents to compare
-		template <class U, int N, class Alloc>
-		friend bool operator!=(const ChunkList& lhs,
-			const ChunkList& rhs) {
-			return !operator==(lhs, rhs);
-		};
-
-		/// @brief Compares the contents of lhs and rhs lexicographically.
-		/// @param lhs,rhs ChunkLists whose contents to compare
-		friend bool operator>(const ChunkList& lhs, const ChunkList& rhs) {
-			
-			if (lhs.list_size < rhs.list_size) return false;
-
-			if (lhs.list_size > rhs.list_size) return true;
-
-			for (int i = 0; i < lhs.list_size; i++)
-				if (rhs.at(i) < lhs.at(i))
-					return true;
-
-			return false;
-		};
-
-		/// @brief Compares the contents of lhs and rhs lexicographically.
-		/// @param lhs,rhs ChunkLists whose contents to compare
-		friend bool operator<(const ChunkList& lhs, const ChunkList& rhs) {
-			if ((lhs > rhs) || (lhs == rhs)) return false;
-			return true;
+			bool equal = true;
+			compare_runs(lhs, rhs, lhs.list_size, [&equal](const T* a, const T* b, int n) {
+				if constexpr (std::is_integral_v<T> || std::is_pointer_v<T>)
+					equal = std::memcmp(a, b, n * sizeof(T)) == 0;
+				else
+					equal = std::equal(a, a + n, b);
+				return equal;
+			});
+			return equal;
 		};
 
-		/// @brief Compares the contents of lhs and rhs lexicographically.
+		/// @brief Compares the contents of lhs and rhs lexicographically, like the
+		/// standard containers: the first unequal pair of elements decides, and a
+		/// list that is a prefix of the other is less.
 		/// @param lhs,rhs ChunkLists whose contents to compare
-		friend bool operator>=(const ChunkList& lhs,
-			const ChunkList& rhs) {
-			return !operator<(lhs, rhs);
-		};
-
-		/// @brief Compares the contents of lhs and rhs lexicographically.
-		/// @param lhs,rhs ChunkLists whose contents to compare
-		friend bool operator<=(const ChunkList& lhs,
-			const ChunkList& rhs) {
-			return !operator>(lhs, rhs);
+		friend synth_ordering operator<=>(const ChunkList& lhs, const ChunkList& rhs) {
+			synth_ordering order = synth_ordering::equivalent;
+			compare_runs(lhs, rhs, std::min(lhs.list_size, rhs.list_size), [&order](const T* a, const T* b, int n) {
+				order = std::lexicographical_compare_three_way(a, a + n, b, b + n, synth_three_way);
+				return order == 0;
+			});
+			if (order != 0)
+				return order;
+			return lhs.list_size <=> rhs.list_size;
 		};
 	};
 
@@ -1063,16 +2708,16 @@ namespace fefu_laboratory_two
 
 	/// @brief  Swaps the contents of lhs and rhs.
 	/// @param lhs,rhs containers whose contents to swap
-	template <class T, int N, class Alloc>
-	void swap(ChunkList<T, N, Alloc>& lhs, ChunkList<T, N, Alloc>& rhs) {
-		std::swap(lhs, rhs);
+	template <class T, auto N, class Alloc>
+	void swap(ChunkList<T, N, Alloc>& lhs, ChunkList<T, N, Alloc>& rhs) noexcept {
+		lhs.swap(rhs);
 	};
 
 	/// @brief Erases all elements that compare equal to value from the container.
 	/// @param c container from which to erase
 	/// @param value value to be removed
 	/// @return The number of erased elements.
-	template <class T, int N, class Alloc, class U>
+	template <class T, auto N, class Alloc, class U>
 	typename ChunkList<T, N, Alloc>::size_type erase(ChunkList<T, N, Alloc>& c, const U& value);
 
 	/// @brief Erases all elements that compare equal to value from the container.
@@ -1080,6 +2725,525 @@ namespace fefu_laboratory_two
 	/// @param pred unary predicate which returns ​true if the element should be
 	/// erased.
 	/// @return The number of erased elements.
-	template <class T, int N, class Alloc, class Pred>
+	template <class T, auto N, class Alloc, class Pred>
 	typename ChunkList<T, N, Alloc>::size_type erase_if(ChunkList<T, N, Alloc>& c, Pred pred);
-}
\ No newline at end of file
+
+	/// SIMD KERNELS
+	/// Reductions and searches over a contiguous array of arithmetic T, used
+	/// on the span of every chunk. int, float and double have AVX2 kernels
+	/// picked at run time when the CPU supports them. Every other type, and
+	/// every CPU without AVX2, uses the scalar loops.
+	namespace simd {
+		/// @brief Type of sum and dot: 64-bit for integers, T for floating point
+		template <typename T>
+		using sum_type = std::conditional_t<std::is_floating_point_v<T>, T,
+			std::conditional_t<std::is_signed_v<T>, long long, unsigned long long>>;
+
+		/// @brief True if T has AVX2 kernels
+		template <typename T>
+		inline constexpr bool has_kernels = std::is_same_v<T, int> || std::is_same_v<T, float> || std::is_same_v<T, double>;
+
+		namespace scalar {
+			template <typename T>
+			sum_type<T> sum(const T* data, std::size_t n) noexcept {
+				sum_type<T> result = 0;
+				for (std::size_t i = 0; i < n; i++) result += data[i];
+				return result;
+			};
+
+			/// @brief Smallest (Max = false) or largest element of a non-empty array
+			template <bool Max, typename T>
+			T extreme(const T* data, std::size_t n) noexcept {
+				T result = data[0];
+				for (std::size_t i = 1; i < n; i++)
+					result = Max ? (result < data[i] ? data[i] : result) : (data[i] < result ? data[i] : result);
+				return result;
+			};
+
+			template <typename T>
+			std::size_t count(const T* data, std::size_t n, T value) noexcept {
+				std::size_t result = 0;
+				for (std::size_t i = 0; i < n; i++) result += data[i] == value;
+				return result;
+			};
+
+			/// @return Index of the first element equal to value, n if there is none
+			template <typename T>
+			std::size_t find(const T* data, std::size_t n, T value) noexcept {
+				for (std::size_t i = 0; i < n; i++)
+					if (data[i] == value) return i;
+				return n;
+			};
+
+			template <typename T>
+			sum_type<T> dot(const T* a, const T* b, std::size_t n) noexcept {
+				sum_type<T> result = 0;
+				for (std::size_t i = 0; i < n; i++) result += static_cast<sum_type<T>>(a[i]) * b[i];
+				return result;
+			};
+		}
+
+#if CHUNKLIST_X86
+		/// @brief Checks once whether the CPU and the OS support AVX2
+		inline bool has_avx2() noexcept {
+			static const bool supported = [] {
+#if defined(_MSC_VER) && !defined(__clang__)
+				int info[4];
+				__cpuid(info, 1);
+				bool osxsave = (info[2] & (1 << 27)) != 0;
+				bool avx = (info[2] & (1 << 28)) != 0;
+				if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) return false;
+				__cpuidex(info, 7, 0);
+				return (info[1] & (1 << 5)) != 0;
+#else
+				__builtin_cpu_init();
+				return __builtin_cpu_supports("avx2") != 0;
+#endif
+			}();
+			return supported;
+		};
+
+		namespace avx2 {
+			CHUNKLIST_AVX2 inline long long hsum(__m256i v) noexcept {
+				alignas(32) long long lanes[4];
+				_mm256_store_si256(reinterpret_cast<__m256i*>(lanes), v);
+				return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+			};
+
+			CHUNKLIST_AVX2 inline float hsum(__m256 v) noexcept {
+				alignas(32) float lanes[8];
+				_mm256_store_ps(lanes, v);
+				return ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+			};
+
+			CHUNKLIST_AVX2 inline double hsum(__m256d v) noexcept {
+				alignas(32) double lanes[4];
+				_mm256_store_pd(lanes, v);
+				return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+			};
+
+			CHUNKLIST_AVX2 inline __m256i load(const int* p) noexcept { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); };
+
+			/// Ints are widened to 64 bits before they are added.
+			CHUNKLIST_AVX2 inline long long sum(const int* data, std::size_t n) noexcept {
+				__m256i lo = _mm256_setzero_si256();
+				__m256i hi = _mm256_setzero_si256();
+				std::size_t i = 0;
+				for (; i + 8 <= n; i += 8) {
+					__m256i v = load(data + i);
+					lo = _mm256_add_epi64(lo, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(v)));
+					hi = _mm256_add_epi64(hi, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(v, 1)));
+				}
+				return hsum(_mm256_add_epi64(lo, hi)) + scalar::sum(data + i, n - i);
+			};
+
+			CHUNKLIST_AVX2 inline float sum(const float* data, std::size_t n) noexcept {
+				__m256 a = _mm256_setzero_ps();
+				__m256 b = _mm256_setzero_ps();
+				std::size_t i = 0;
+				for (; i + 16 <= n; i += 16) {
+					a = _mm256_add_ps(a, _mm256_loadu_ps(data + i));
+					b = _mm256_add_ps(b, _mm256_loadu_ps(data + i + 8));
+				}
+				for (; i + 8 <= n; i += 8)
+					a = _mm256_add_ps(a, _mm256_loadu_ps(data + i));
+				return hsum(_mm256_add_ps(a, b)) + scalar::sum(data + i, n - i);
+			};
+
+			CHUNKLIST_AVX2 inline double sum(const double* data, std::size_t n) noexcept {
+				__m256d a = _mm256_setzero_pd();
+				__m256d b = _mm256_setzero_pd();
+				std::size_t i = 0;
+				for (; i + 8 <= n; i += 8) {
+					a = _mm256_add_pd(a, _mm256_loadu_pd(data + i));
+					b = _mm256_add_pd(b, _mm256_loadu_pd(data + i + 4));
+				}
+				for (; i + 4 <= n; i += 4)
+					a = _mm256_add_pd(a, _mm256_loadu_pd(data + i));
+				return hsum(_mm256_add_pd(a, b)) + scalar::sum(data + i, n - i);
+			};
+
+			template <bool Max>
+			CHUNKLIST_AVX2 int extreme(const int* data, std::size_t n) noexcept {
+				__m256i m = _mm256_set1_epi32(data[0]);
+				std::size_t i = 0;
+				for (; i + 8 <= n; i += 8)
+					m = Max ? _mm256_max_epi32(m, load(data + i)) : _mm256_min_epi32(m, load(data + i));
+				alignas(32) int lanes[8];
+				_mm256_store_si256(reinterpret_cast<__m256i*>(lanes), m);
+				int result = scalar::extreme<Max>(lanes, 8);
+				for (; i < n; i++)
+					result = Max ? std::max(result, data[i]) : std::min(result, data[i]);
+				return result;
+			};
+
+			template <bool Max>
+			CHUNKLIST_AVX2 float extreme(const float* data, std::size_t n) noexcept {
+				__m256 m = _mm256_set1_ps(data[0]);
+				std::size_t i = 0;
+				for (; i + 8 <= n; i += 8)
+					m = Max ? _mm256_max_ps(m, _mm256_loadu_ps(data + i)) : _mm256_min_ps(m, _mm256_loadu_ps(data + i));
+				alignas(32) float lanes[8];
+				_mm256_store_ps(lanes, m);
+				float result = scalar::extreme<Max>(lanes, 8);
+				for (; i < n; i++)
+					result = Max ? std::max(result, data[i]) : std::min(result, data[i]);
+				return result;
+			};
+
+			template <bool Max>
+			CHUNKLIST_AVX2 double extreme(const double* data, std::size_t n) noexcept {
+				__m256d m = _mm256_set1_pd(data[0]);
+				std::size_t i = 0;
+				for (; i + 4 <= n; i += 4)
+					m = Max ? _mm256_max_pd(m, _mm256_loadu_pd(data + i)) : _mm256_min_pd(m, _mm256_loadu_pd(data + i));
+				alignas(32) double lanes[4];
+				_mm256_store_pd(lanes, m);
+				double result = scalar::extreme<Max>(lanes, 4);
+				for (; i < n; i++)
+					result = Max ? std::max(result, data[i]) : std::min(result, data[i]);
+				return result;
+			};
+
+			/// Equal lanes are all ones, i.e. -1, so subtracting the comparison
+			/// mask counts the matches per lane.
+			CHUNKLIST_AVX2 inline std::size_t count(const int* data, std::size_t n, int value) noexcept {
+				__m256i needle = _mm256_set1_epi32(value);
+				__m256i hits = _mm256_setzero_si256();
+				std::size_t i = 0;
+				for (; i + 8 <= n; i += 8)
+					hits = _mm256_sub_epi32(hits, _mm256_cmpeq_epi32(load(data + i), needle));
+				__m256i wide = _mm256_add_epi64(_mm256_cvtepu32_epi64(_mm256_castsi256_si128(hits)),
+					_mm256_cvtepu32_epi64(_mm256_extracti128_si256(hits, 1)));
+				return static_cast<std::size_t>(hsum(wide)) + scalar::count(data + i, n - i, value);
+			};
+
+			CHUNKLIST_AVX2 inline std::size_t count(const float* data, std::size_t n, float value) noexcept {
+				__m256 needle = _mm256_set1_ps(value);
+				__m256i hits = _mm256_setzero_si256();
+				std::size_t i = 0;
+				for (; i + 8 <= n; i += 8)
+					hits = _mm256_sub_epi32(hits, _mm256_castps_si256(_mm256_cmp_ps(_mm256_loadu_ps(data + i), needle, _CMP_EQ_OQ)));
+				__m256i wide = _mm256_add_epi64(_mm256_cvtepu32_epi64(_mm256_castsi256_si128(hits)),
+					_mm256_cvtepu32_epi64(_mm256_extracti128_si256(hits, 1)));
+				return static_cast<std::size_t>(hsum(wide)) + scalar::count(data + i, n - i, value);
+			};
+
+			CHUNKLIST_AVX2 inline std::size_t count(const double* data, std::size_t n, double value) noexcept {
+				__m256d needle = _mm256_set1_pd(value);
+				__m256i hits = _mm256_setzero_si256();
+				std::size_t i = 0;
+				for (; i + 4 <= n; i += 4)
+					hits = _mm256_sub_epi64(hits, _mm256_castpd_si256(_mm256_cmp_pd(_mm256_loadu_pd(data + i), needle, _CMP_EQ_OQ)));
+				return static_cast<std::size_t>(hsum(hits)) + scalar::count(data + i, n - i, value);
+			};
+
+			CHUNKLIST_AVX2 inline std::size_t find(const int* data, std::size_t n, int value) noexcept {
+				__m256i needle = _mm256_set1_epi32(value);
+				std::size_t i = 0;
+				for (; i + 8 <= n; i += 8) {
+					int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(load(data + i), needle)));
+					if (mask != 0) return i + std::countr_zero(static_cast<unsigned>(mask));
+				}
+				return i + scalar::find(data + i, n - i, value);
+			};
+
+			CHUNKLIST_AVX2 inline std::size_t find(const float* data, std::size_t n, float value) noexcept {
+				__m256 needle = _mm256_set1_ps(value);
+				std::size_t i = 0;
+				for (; i + 8 <= n; i += 8) {
+					int mask = _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(data + i), needle, _CMP_EQ_OQ));
+					if (mask != 0) return i + std::countr_zero(static_cast<unsigned>(mask));
+				}
+				return i + scalar::find(data + i, n - i, value);
+			};
+
+			CHUNKLIST_AVX2 inline std::size_t find(const double* data, std::size_t n, double value) noexcept {
+				__m256d needle = _mm256_set1_pd(value);
+				std::size_t i = 0;
+				for (; i + 4 <= n; i += 4) {
+					int mask = _mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(data + i), needle, _CMP_EQ_OQ));
+					if (mask != 0) return i + std::countr_zero(static_cast<unsigned>(mask));
+				}
+				return i + scalar::find(data + i, n - i, value);
+			};
+
+			/// _mm256_mul_epi32 multiplies the low halves of the 64-bit lanes,
+			/// so even and odd ints are multiplied in two passes.
+			CHUNKLIST_AVX2 inline long long dot(const int* a, const int* b, std::size_t n) noexcept {
+				__m256i acc = _mm256_setzero_si256();
+				std::size_t i = 0;
+				for (; i + 8 <= n; i += 8) {
+					__m256i x = load(a + i);
+					__m256i y = load(b + i);
+					acc = _mm256_add_epi64(acc, _mm256_mul_epi32(x, y));
+					acc = _mm256_add_epi64(acc, _mm256_mul_epi32(_mm256_srli_epi64(x, 32), _mm256_srli_epi64(y, 32)));
+				}
+				return hsum(acc) + scalar::dot(a + i, b + i, n - i);
+			};
+
+			CHUNKLIST_AVX2 inline float dot(const float* a, const float* b, std::size_t n) noexcept {
+				__m256 acc0 = _mm256_setzero_ps();
+				__m256 acc1 = _mm256_setzero_ps();
+				std::size_t i = 0;
+				for (; i + 16 <= n; i += 16) {
+					acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+					acc1 = _mm256_add_ps(acc1, _mm256_mul_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8)));
+				}
+				for (; i + 8 <= n; i += 8)
+					acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+				return hsum(_mm256_add_ps(acc0, acc1)) + scalar::dot(a + i, b + i, n - i);
+			};
+
+			CHUNKLIST_AVX2 inline double dot(const double* a, const double* b, std::size_t n) noexcept {
+				__m256d acc0 = _mm256_setzero_pd();
+				__m256d acc1 = _mm256_setzero_pd();
+				std::size_t i = 0;
+				for (; i + 8 <= n; i += 8) {
+					acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+					acc1 = _mm256_add_pd(acc1, _mm256_mul_pd(_mm256_loadu_pd(a + i + 4), _mm256_loadu_pd(b + i + 4)));
+				}
+				for (; i + 4 <= n; i += 4)
+					acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+				return hsum(_mm256_add_pd(acc0, acc1)) + scalar::dot(a + i, b + i, n - i);
+			};
+		}
+#endif
+
+		/// @brief True if the AVX2 kernels of T can run on this CPU
+		template <typename T>
+		bool use_avx2() noexcept {
+#if CHUNKLIST_X86
+			if constexpr (has_kernels<T>)
+				return has_avx2();
+#endif
+			return false;
+		};
+
+		template <typename T>
+		sum_type<T> sum(const T* data, std::size_t n) noexcept {
+#if CHUNKLIST_X86
+			if constexpr (has_kernels<T>)
+				if (use_avx2<T>()) return avx2::sum(data, n);
+#endif
+			return scalar::sum(data, n);
+		};
+
+		template <bool Max, typename T>
+		T extreme(const T* data, std::size_t n) noexcept {
+#if CHUNKLIST_X86
+			if constexpr (has_kernels<T>)
+				if (use_avx2<T>()) return avx2::extreme<Max>(data, n);
+#endif
+			return scalar::extreme<Max>(data, n);
+		};
+
+		template <typename T>
+		std::size_t count(const T* data, std::size_t n, T value) noexcept {
+#if CHUNKLIST_X86
+			if constexpr (has_kernels<T>)
+				if (use_avx2<T>()) return avx2::count(data, n, value);
+#endif
+			return scalar::count(data, n, value);
+		};
+
+		template <typename T>
+		std::size_t find(const T* data, std::size_t n, T value) noexcept {
+#if CHUNKLIST_X86
+			if constexpr (has_kernels<T>)
+				if (use_avx2<T>()) return avx2::find(data, n, value);
+#endif
+			return scalar::find(data, n, value);
+		};
+
+		template <typename T>
+		sum_type<T> dot(const T* a, const T* b, std::size_t n) noexcept {
+#if CHUNKLIST_X86
+			if constexpr (has_kernels<T>)
+				if (use_avx2<T>()) return avx2::dot(a, b, n);
+#endif
+			return scalar::dot(a, b, n);
+		};
+	}
+
+	/// SEGMENTED ALGORITHMS
+	/// Each runs the standard algorithm over one chunk span at a time, so the
+	/// inner loop works on a plain array and no iterator checks chunk bounds.
+
+	/// @brief Applies f to every element of c in order.
+	/// @param c container to traverse
+	/// @param f function object to apply
+	/// @return f
+	template <class T, auto N, class Alloc, class UnaryFunc>
+	UnaryFunc for_each(ChunkList<T, N, Alloc>& c, UnaryFunc f) {
+		for (std::span<T> span : c.chunks())
+			for (T& value : span)
+				f(value);
+		return f;
+	};
+
+	/// @brief Applies f to every element of c in order.
+	/// @param c container to traverse
+	/// @param f function object to apply
+	/// @return f
+	template <class T, auto N, class Alloc, class UnaryFunc>
+	UnaryFunc for_each(const ChunkList<T, N, Alloc>& c, UnaryFunc f) {
+		for (std::span<const T> span : c.chunks())
+			for (const T& value : span)
+				f(value);
+		return f;
+	};
+
+	/// @brief Folds the elements of c into init with op, in order.
+	/// @param c container to fold
+	/// @param init initial value
+	/// @param op binary operation, addition by default
+	/// @return The folded value.
+	template <class T, auto N, class Alloc, class U, class BinaryOp = std::plus<>>
+	U accumulate(const ChunkList<T, N, Alloc>& c, U init, BinaryOp op = BinaryOp()) {
+		for (std::span<const T> span : c.chunks())
+			init = std::accumulate(span.begin(), span.end(), std::move(init), op);
+		return init;
+	};
+
+	/// @brief Finds the first element of c equal to value.
+	/// @param c container to search
+	/// @param value value to compare the elements to
+	/// @return Iterator to the first equal element, end() if there is none.
+	template <class T, auto N, class Alloc, class U>
+	typename ChunkList<T, N, Alloc>::const_iterator find(const ChunkList<T, N, Alloc>& c, const U& value) {
+		std::size_t index = 0;
+		for (std::span<const T> span : c.chunks()) {
+			std::size_t found;
+			if constexpr (std::is_same_v<T, U> && std::is_arithmetic_v<T>)
+				found = simd::find(span.data(), span.size(), value);
+			else
+				found = std::find(span.begin(), span.end(), value) - span.begin();
+			if (found != span.size())
+				return c.cbegin() + (index + found);
+			index += span.size();
+		}
+		return c.cend();
+	};
+
+	/// @brief Finds the first element of c equal to value.
+	/// @param c container to search
+	/// @param value value to compare the elements to
+	/// @return Iterator to the first equal element, end() if there is none.
+	template <class T, auto N, class Alloc, class U>
+	typename ChunkList<T, N, Alloc>::iterator find(ChunkList<T, N, Alloc>& c, const U& value) {
+		return c.begin() + (find(std::as_const(c), value) - c.cbegin());
+	};
+
+	/// @brief Counts the elements of c equal to value.
+	/// @param c container to search
+	/// @param value value to compare the elements to
+	/// @return The number of equal elements.
+	template <class T, auto N, class Alloc, class U>
+	typename ChunkList<T, N, Alloc>::size_type count(const ChunkList<T, N, Alloc>& c, const U& value) {
+		typename ChunkList<T, N, Alloc>::size_type result = 0;
+		for (std::span<const T> span : c.chunks()) {
+			if constexpr (std::is_same_v<T, U> && std::is_arithmetic_v<T>)
+				result += simd::count(span.data(), span.size(), value);
+			else
+				result += std::count(span.begin(), span.end(), value);
+		}
+		return result;
+	};
+
+	/// @brief Copies the elements of c, in order, to the range beginning at out.
+	/// @param c container to copy from
+	/// @param out beginning of the destination range
+	/// @return Output iterator past the last copied element.
+	template <class T, auto N, class Alloc, class OutputIt>
+	OutputIt copy(const ChunkList<T, N, Alloc>& c, OutputIt out) {
+		for (std::span<const T> span : c.chunks())
+			out = std::copy(span.begin(), span.end(), out);
+		return out;
+	};
+
+	/// @brief Assigns value to every element of c.
+	/// @param c container to fill
+	/// @param value the value to assign
+	template <class T, auto N, class Alloc>
+	void fill(ChunkList<T, N, Alloc>& c, const T& value) {
+		for (std::span<T> span : c.chunks())
+			std::fill(span.begin(), span.end(), value);
+	};
+
+	/// @brief Sums the elements of c. Integers are summed in 64 bits.
+	/// @param c container of arithmetic elements
+	/// @return The sum, 0 for an empty container.
+	template <class T, auto N, class Alloc>
+		requires std::is_arithmetic_v<T>
+	simd::sum_type<T> sum(const ChunkList<T, N, Alloc>& c) {
+		simd::sum_type<T> result = 0;
+		for (std::span<const T> span : c.chunks())
+			result += simd::sum(span.data(), span.size());
+		return result;
+	};
+
+	/// @brief Returns the smallest element of c. The result is unspecified if
+	/// floating point elements include NaN.
+	/// @param c container of arithmetic elements
+	/// @return The smallest element.
+	template <class T, auto N, class Alloc>
+		requires std::is_arithmetic_v<T>
+	T min(const ChunkList<T, N, Alloc>& c) {
+		if (c.empty())
+			throw std::out_of_range("ChunkList is empty");
+		T result = c.front();
+		for (std::span<const T> span : c.chunks())
+			result = std::min(result, simd::extreme<false>(span.data(), span.size()));
+		return result;
+	};
+
+	/// @brief Returns the largest element of c. The result is unspecified if
+	/// floating point elements include NaN.
+	/// @param c container of arithmetic elements
+	/// @return The largest element.
+	template <class T, auto N, class Alloc>
+		requires std::is_arithmetic_v<T>
+	T max(const ChunkList<T, N, Alloc>& c) {
+		if (c.empty())
+			throw std::out_of_range("ChunkList is empty");
+		T result = c.front();
+		for (std::span<const T> span : c.chunks())
+			result = std::max(result, simd::extreme<true>(span.data(), span.size()));
+		return result;
+	};
+
+	/// @brief Dot product of the elements of lhs and rhs. Integers are
+	/// multiplied and summed in 64 bits.
+	/// @param lhs,rhs containers of the same size
+	/// @return The sum of the products of elements at equal positions.
+	template <class T, auto N, class Alloc>
+		requires std::is_arithmetic_v<T>
+	simd::sum_type<T> dot(const ChunkList<T, N, Alloc>& lhs, const ChunkList<T, N, Alloc>& rhs) {
+		if (lhs.size() != rhs.size())
+			throw std::invalid_argument("ChunkLists differ in size");
+		simd::sum_type<T> result = 0;
+		auto a = lhs.chunks().begin();
+		auto b = rhs.chunks().begin();
+		std::size_t a_offset = 0;
+		std::size_t b_offset = 0;
+		for (std::size_t left = lhs.size(); left > 0;) {
+			std::span<const T> x = *a;
+			std::span<const T> y = *b;
+			std::size_t n = std::min({ left, x.size() - a_offset, y.size() - b_offset });
+			result += simd::dot(x.data() + a_offset, y.data() + b_offset, n);
+			a_offset += n;
+			b_offset += n;
+			left -= n;
+			if (a_offset == x.size()) {
+				++a;
+				a_offset = 0;
+			}
+			if (b_offset == y.size()) {
+				++b;
+				b_offset = 0;
+			}
+		}
+		return result;
+	};
+}
@@ -0,0 +1,291 @@
+﻿#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+#include "ChunkList.h"
+
+namespace fefu_laboratory_two
+{
+	/// @brief Fixed set of worker threads with a task queue per worker.
+	/// A worker runs tasks from the back of its own queue and steals from the
+	/// front of the other queues when its own runs dry. A thread waiting for a
+	/// batch runs queued tasks meanwhile, so batches may be nested.
+	class ThreadPool {
+		struct Queue {
+			std::mutex mutex;
+			std::deque<std::function<void()>> tasks;
+		};
+
+		std::vector<std::unique_ptr<Queue>> queues;
+		std::vector<std::thread> workers;
+		std::atomic<std::size_t> queued = 0;
+		std::mutex sleep_mutex;
+		std::condition_variable wake;
+		bool stopping = false;
+
+		bool take(std::size_t index, bool own, std::function<void()>& task) {
+			Queue& queue = *queues[index];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			if (queue.tasks.empty()) return false;
+			if (own) {
+				task = std::move(queue.tasks.back());
+				queue.tasks.pop_back();
+			}
+			else {
+				task = std::move(queue.tasks.front());
+				queue.tasks.pop_front();
+			}
+			return true;
+		};
+
+		/// @brief Runs one queued task, taken from queue home or stolen from
+		/// the next non-empty queue.
+		/// @return false if every queue was empty
+		bool run_one(std::size_t home) {
+			std::function<void()> task;
+			bool found = take(home, true, task);
+			for (std::size_t i = 1; !found && i < queues.size(); i++)
+				found = take((home + i) % queues.size(), false, task);
+			if (!found) return false;
+			queued--;
+			task();
+			return true;
+		};
+
+		void work(std::size_t index) {
+			while (true) {
+				if (run_one(index)) continue;
+				std::unique_lock<std::mutex> lock(sleep_mutex);
+				wake.wait(lock, [this] { return stopping || queued > 0; });
+				if (stopping && queued == 0) return;
+			}
+		};
+
+	public:
+		/// @param threads number of worker threads
+		explicit ThreadPool(unsigned threads = std::max(1u, std::thread::hardware_concurrency())) {
+			for (unsigned i = 0; i < threads; i++)
+				queues.push_back(std::make_unique<Queue>());
+			for (unsigned i = 0; i < threads; i++)
+				workers.emplace_back(&ThreadPool::work, this, i);
+		};
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		~ThreadPool() {
+			{
+				std::lock_guard<std::mutex> lock(sleep_mutex);
+				stopping = true;
+			}
+			wake.notify_all();
+			for (std::thread& worker : workers) worker.join();
+		};
+
+		/// @brief Number of worker threads
+		std::size_t size() const noexcept { return workers.size(); };
+
+		/// @brief Runs task(i) for every i in [0, count) and returns when all of
+		/// them have finished. Consecutive indices are dealt to the same queue.
+		/// Rethrows the first exception thrown by a task.
+		template <class Task>
+		void parallel_for(std::size_t count, Task&& task) {
+			if (count == 0) return;
+			if (count == 1 || workers.empty()) {
+				for (std::size_t i = 0; i < count; i++) task(i);
+				return;
+			}
+
+			std::atomic<std::size_t> left = count;
+			std::exception_ptr error;
+			std::mutex error_mutex;
+			auto run = [&](std::size_t i) {
+				try {
+					task(i);
+				}
+				catch (...) {
+					std::lock_guard<std::mutex> lock(error_mutex);
+					if (!error) error = std::current_exception();
+				}
+				left--;
+			};
+
+			queued += count;
+			std::size_t share = (count + queues.size() - 1) / queues.size();
+			for (std::size_t q = 0; q < queues.size(); q++) {
+				std::lock_guard<std::mutex> lock(queues[q]->mutex);
+				for (std::size_t i = q * share; i < std::min(count, (q + 1) * share); i++)
+					queues[q]->tasks.emplace_back([&run, i] { run(i); });
+			}
+			{
+				std::lock_guard<std::mutex> lock(sleep_mutex);
+			}
+			wake.notify_all();
+
+			while (left > 0)
+				if (!run_one(0))
+					std::this_thread::yield();
+			if (error)
+				std::rethrow_exception(error);
+		};
+
+		/// @brief Pool shared by the parallel algorithms, one thread per core
+		static ThreadPool& instance() {
+			static ThreadPool pool;
+			return pool;
+		};
+	};
+
+	/// @brief Execution policy of the parallel ChunkList algorithms.
+	/// Runs on pool, or on ThreadPool::instance() if pool is nullptr.
+	struct parallel_policy {
+		ThreadPool* pool = nullptr;
+
+		ThreadPool& executor() const { return pool != nullptr ? *pool : ThreadPool::instance(); };
+	};
+
+	/// @brief Runs the algorithms on the shared pool
+	inline constexpr parallel_policy par{};
+
+	/// @brief Number of runs for_chunk_runs cuts chunks into: a few per worker,
+	/// so that stealing can even out the load.
+	template <class Chunks>
+	std::size_t chunk_runs(const parallel_policy& policy, const Chunks& chunks) {
+		return std::min(chunks.size(), policy.executor().size() * 4);
+	};
+
+	/// @brief Splits chunks into chunk_runs runs of consecutive chunks and calls
+	/// body(run, first, last) for the chunk indices [first, last) of every run
+	/// on the pool. Runs are cut by chunk index through the directory, nothing
+	/// walks the chain.
+	template <class Chunks, class Body>
+	void for_chunk_runs(const parallel_policy& policy, const Chunks& chunks, Body body) {
+		std::size_t count = chunks.size();
+		std::size_t runs = chunk_runs(policy, chunks);
+		policy.executor().parallel_for(runs, [&](std::size_t run) {
+			body(run, run * count / runs, (run + 1) * count / runs);
+		});
+	};
+
+	/// PARALLEL ALGORITHMS
+
+	/// @brief Applies f to every element of c, chunk runs in parallel.
+	/// @param policy pool to run on
+	/// @param c container to traverse
+	/// @param f function object, called concurrently
+	template <class T, auto N, class Alloc, class UnaryFunc>
+	void for_each(const parallel_policy& policy, ChunkList<T, N, Alloc>& c, UnaryFunc f) {
+		auto chunks = c.chunks();
+		for_chunk_runs(policy, chunks, [&](std::size_t, std::size_t first, std::size_t last) {
+			for (std::size_t k = first; k < last; k++)
+				for (T& value : chunks[k])
+					f(value);
+		});
+	};
+
+	/// @brief Stores op(x) for every element x of in at the same position of
+	/// out, chunk runs in parallel. out is resized to the size of in; in and
+	/// out may be the same list.
+	/// @param policy pool to run on
+	/// @param in container to read
+	/// @param out container to write
+	/// @param op function object, called concurrently
+	template <class T, auto N, class Alloc, class U, auto M, class OutAlloc, class UnaryOp>
+	void transform(const parallel_policy& policy, const ChunkList<T, N, Alloc>& in, ChunkList<U, M, OutAlloc>& out, UnaryOp op) {
+		out.resize(in.size());
+		// Taken once up front: the mutable begin() makes shared chunks private,
+		// which must not run on several workers at once.
+		auto base = out.begin();
+		auto chunks = in.chunks();
+		for_chunk_runs(policy, chunks, [&](std::size_t, std::size_t first, std::size_t last) {
+			auto it = base + chunks.position(first);
+			for (std::size_t k = first; k < last; k++)
+				for (const T& value : chunks[k])
+					*it++ = op(value);
+		});
+	};
+
+	/// @brief Folds the elements of c and init with op. Chunk runs are folded
+	/// in parallel, so op must be associative and commutative.
+	/// @param policy pool to run on
+	/// @param c container to fold
+	/// @param init initial value
+	/// @param op binary operation, addition by default
+	/// @return The folded value.
+	template <class T, auto N, class Alloc, class U, class BinaryOp = std::plus<>>
+	U reduce(const parallel_policy& policy, const ChunkList<T, N, Alloc>& c, U init, BinaryOp op = BinaryOp()) {
+		auto chunks = c.chunks();
+		std::vector<std::optional<U>> partial(chunk_runs(policy, chunks));
+		for_chunk_runs(policy, chunks, [&](std::size_t run, std::size_t first, std::size_t last) {
+			std::optional<U>& result = partial[run];
+			for (std::size_t k = first; k < last; k++) {
+				auto span = chunks[k];
+				auto it = span.begin();
+				if (!result) result.emplace(*it++);
+				result = std::accumulate(it, span.end(), std::move(*result), op);
+			}
+		});
+		for (std::optional<U>& result : partial)
+			if (result) init = op(std::move(init), std::move(*result));
+		return init;
+	};
+
+	/// @brief Counts the elements of c for which pred returns true, chunk runs
+	/// in parallel.
+	/// @param policy pool to run on
+	/// @param c container to search
+	/// @param pred unary predicate, called concurrently
+	/// @return The number of matching elements.
+	template <class T, auto N, class Alloc, class Pred>
+	typename ChunkList<T, N, Alloc>::size_type count_if(const parallel_policy& policy, const ChunkList<T, N, Alloc>& c, Pred pred) {
+		auto chunks = c.chunks();
+		std::vector<typename ChunkList<T, N, Alloc>::size_type> partial(chunk_runs(policy, chunks));
+		for_chunk_runs(policy, chunks, [&](std::size_t run, std::size_t first, std::size_t last) {
+			typename ChunkList<T, N, Alloc>::size_type result = 0;
+			for (std::size_t k = first; k < last; k++)
+				result += std::count_if(chunks[k].begin(), chunks[k].end(), pred);
+			partial[run] = result;
+		});
+		return std::accumulate(partial.begin(), partial.end(), typename ChunkList<T, N, Alloc>::size_type(0));
+	};
+
+	/// @brief Sorts c. Blocks of whole chunks are sorted in parallel, then
+	/// neighbouring blocks are merged pairwise, the pairs of a round in
+	/// parallel.
+	/// @param policy pool to run on
+	/// @param c container to sort
+	/// @param comp comparison function object
+	template <class T, auto N, class Alloc, class Compare = std::less<>>
+	void sort(const parallel_policy& policy, ChunkList<T, N, Alloc>& c, Compare comp = Compare()) {
+		ThreadPool& pool = policy.executor();
+		auto base = c.begin();
+		auto chunks = c.chunks();
+		std::size_t blocks = std::min(chunks.size(), pool.size());
+		if (blocks == 0) return;
+		auto bound = [&](std::size_t block) {
+			std::size_t chunk = block * chunks.size() / blocks;
+			return chunk < chunks.size() ? chunks.position(chunk) : c.size();
+		};
+
+		pool.parallel_for(blocks, [&](std::size_t block) {
+			std::sort(base + bound(block), base + bound(block + 1), comp);
+		});
+		for (std::size_t width = 1; width < blocks; width *= 2) {
+			std::size_t pairs = (blocks + 2 * width - 1) / (2 * width);
+			pool.parallel_for(pairs, [&](std::size_t pair) {
+				std::size_t lo = pair * 2 * width;
+				if (lo + width >= blocks) return;
+				std::inplace_merge(base + bound(lo), base + bound(lo + width),
+					base + bound(std::min(blocks, lo + 2 * width)), comp);
+			});
+		}
+	};
+}
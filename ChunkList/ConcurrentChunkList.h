@@ -0,0 +1,254 @@
+﻿#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <utility>
+#include "ChunkList.h"
+
+namespace fefu_laboratory_two
+{
+	/// @brief Append-only chunk list for many concurrent producers.
+	/// push_back and emplace_back are lock-free apart from the allocation of a
+	/// new chunk: a slot is reserved with a fetch_add on the size of the tail
+	/// chunk, and a full tail is followed by a new chunk linked in with a CAS.
+	/// Iteration runs concurrently with the producers without locks and sees a
+	/// prefix of the published elements; a slot reserved but not yet published
+	/// ends the traversal. Elements are never moved or erased while the list is
+	/// shared, so references to them stay valid. The allocator must be
+	/// thread-safe, the default one is.
+	template <typename T, int N, typename Allocator = Allocator<T>>
+	class ConcurrentChunkList {
+		static_assert(N > 0, "chunk size must be positive");
+		using alloc_traits = std::allocator_traits<Allocator>;
+
+		/// Slot states. A reserved slot is empty until its element is
+		/// constructed, failed if the constructor threw.
+		enum SlotState : unsigned char { empty_slot, published_slot, failed_slot };
+
+		/// node_size counts reserved slots and keeps growing past N while
+		/// producers race for a full chunk, only slots below N are real.
+		struct alignas(chunk_alignment) ChunkNode {
+			std::atomic<ChunkNode*> next = nullptr;
+			std::atomic<int> node_size = 0;
+			std::atomic<unsigned char> state[N] = {};
+			union { T list[N]; };
+
+			ChunkNode() noexcept {}
+			ChunkNode(const ChunkNode&) = delete;
+			ChunkNode& operator=(const ChunkNode&) = delete;
+			~ChunkNode() {}
+		};
+
+		/// @brief Forward iterator over the published elements.
+		/// Compares equal to std::default_sentinel at the first slot that is not
+		/// published yet. Failed slots are skipped, and the end of a full chunk
+		/// is left for its successor once the successor is linked, so an end
+		/// iterator moves on when producers publish more elements.
+		class ConstIterator {
+			friend class ConcurrentChunkList;
+
+			mutable const ChunkNode* node = nullptr;
+			mutable int index = 0;
+
+			ConstIterator(const ChunkNode* node, int index) noexcept : node(node), index(index) {};
+
+			/// @brief Steps past failed slots and into the next chunk at the end
+			/// of a full one. Only moves over slots that can never be published.
+			/// A value-initialized iterator has no chunk and stays where it is.
+			void settle() const noexcept {
+				if (node == nullptr) return;
+				while (true) {
+					if (index == N) {
+						const ChunkNode* next = node->next.load(std::memory_order_acquire);
+						if (next == nullptr) return;
+						node = next;
+						index = 0;
+					}
+					if (node->state[index].load(std::memory_order_acquire) != failed_slot) return;
+					index++;
+				}
+			};
+
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = T;
+			using difference_type = std::ptrdiff_t;
+			using pointer = const T*;
+			using reference = const T&;
+
+			ConstIterator() noexcept = default;
+
+			reference operator*() const noexcept {
+				settle();
+				return node->list[index];
+			};
+
+			pointer operator->() const noexcept { return std::addressof(**this); };
+
+			ConstIterator& operator++() noexcept {
+				settle();
+				index++;
+				settle();
+				return *this;
+			};
+
+			ConstIterator operator++(int) noexcept {
+				ConstIterator tmp = *this;
+				++*this;
+				return tmp;
+			};
+
+			friend bool operator==(const ConstIterator& lhs, const ConstIterator& rhs) noexcept {
+				lhs.settle();
+				rhs.settle();
+				return lhs.node == rhs.node && lhs.index == rhs.index;
+			};
+
+			friend bool operator==(const ConstIterator& it, std::default_sentinel_t) noexcept {
+				it.settle();
+				return it.node == nullptr || it.index == N || it.node->state[it.index].load(std::memory_order_acquire) != published_slot;
+			};
+		};
+
+	public:
+		using value_type = T;
+		using allocator_type = Allocator;
+		using size_type = std::size_t;
+		using difference_type = std::ptrdiff_t;
+		using reference = value_type&;
+		using const_reference = const value_type&;
+		using iterator = ConstIterator;
+		using const_iterator = ConstIterator;
+
+		/// @brief Size in bytes of one chunk block, header and slot states included
+		static constexpr std::size_t chunk_bytes = sizeof(ChunkNode);
+
+	protected:
+		using node_allocator = typename alloc_traits::template rebind_alloc<ChunkNode>;
+		using node_traits = std::allocator_traits<node_allocator>;
+
+		Allocator allocator;
+		ChunkNode* first = nullptr;
+		/// Last chunk, or a chunk close to it while a producer is linking a new
+		/// one. Producers that find it full help to move it forward.
+		std::atomic<ChunkNode*> tail = nullptr;
+		/// Published elements, failed slots are not counted.
+		std::atomic<size_type> list_size = 0;
+
+		/// @brief Allocates an empty chunk from the allocator
+		ChunkNode* create_node() {
+			node_allocator node_alloc(allocator);
+			return ::new (static_cast<void*>(node_traits::allocate(node_alloc, 1))) ChunkNode();
+		};
+
+		/// @brief Destroys the published elements of a chunk and gives its block
+		/// back to the allocator. Must not race with producers.
+		void destroy_node(ChunkNode* node) noexcept {
+			int count = std::min(node->node_size.load(std::memory_order_relaxed), N);
+			for (int i = 0; i < count; i++)
+				if (node->state[i].load(std::memory_order_relaxed) == published_slot)
+					alloc_traits::destroy(allocator, node->list + i);
+			node->~ChunkNode();
+			node_allocator node_alloc(allocator);
+			node_traits::deallocate(node_alloc, node, 1);
+		};
+
+		/// @brief Reserves a free slot, linking a new tail chunk when the current
+		/// one is full.
+		/// @param index set to the reserved slot of the returned chunk
+		/// @return The chunk holding the reserved slot.
+		ChunkNode* reserve(int& index) {
+			ChunkNode* node = tail.load(std::memory_order_acquire);
+			while (true) {
+				index = node->node_size.fetch_add(1, std::memory_order_relaxed);
+				if (index < N) return node;
+
+				ChunkNode* next = node->next.load(std::memory_order_acquire);
+				if (next == nullptr) {
+					ChunkNode* fresh = create_node();
+					if (node->next.compare_exchange_strong(next, fresh, std::memory_order_acq_rel))
+						next = fresh;
+					else
+						destroy_node(fresh);
+				}
+				tail.compare_exchange_strong(node, next, std::memory_order_acq_rel);
+				node = tail.load(std::memory_order_acquire);
+			}
+		};
+
+	public:
+		/// @brief Default constructor
+		ConcurrentChunkList() : ConcurrentChunkList(Allocator()) {};
+
+		/// @brief Constructs an empty list with the given allocator
+		/// @param alloc allocator to use for all memory allocations of this container
+		explicit ConcurrentChunkList(const Allocator& alloc) : allocator(alloc) {
+			first = create_node();
+			tail.store(first, std::memory_order_relaxed);
+		};
+
+		ConcurrentChunkList(const ConcurrentChunkList&) = delete;
+		ConcurrentChunkList& operator=(const ConcurrentChunkList&) = delete;
+
+		/// @brief Destructs the list. Must not race with producers or readers.
+		~ConcurrentChunkList() {
+			for (ChunkNode* node = first; node != nullptr;) {
+				ChunkNode* next = node->next.load(std::memory_order_relaxed);
+				destroy_node(node);
+				node = next;
+			}
+		};
+
+		/// @brief Returns the allocator associated with the container
+		allocator_type get_allocator() const noexcept { return allocator; };
+
+		/// @brief Appends a new element constructed in place. Safe to call from
+		/// any number of threads at once. If the constructor throws, the reserved
+		/// slot is marked failed and skipped by readers.
+		/// @param args arguments to forward to the constructor of the element
+		/// @return A reference to the new element.
+		template <class... Args>
+		const_reference emplace_back(Args&&... args) {
+			int index;
+			ChunkNode* node = reserve(index);
+			try {
+				alloc_traits::construct(allocator, node->list + index, std::forward<Args>(args)...);
+			}
+			catch (...) {
+				node->state[index].store(failed_slot, std::memory_order_release);
+				throw;
+			}
+			node->state[index].store(published_slot, std::memory_order_release);
+			list_size.fetch_add(1, std::memory_order_relaxed);
+			return node->list[index];
+		};
+
+		/// @brief Appends the given element value. Safe to call concurrently.
+		void push_back(const T& value) { emplace_back(value); };
+
+		/// @brief Appends the given element value. Safe to call concurrently.
+		void push_back(T&& value) { emplace_back(std::move(value)); };
+
+		/// @brief Number of published elements. Elements still being constructed
+		/// are not counted, so it may lag behind concurrent producers.
+		size_type size() const noexcept { return list_size.load(std::memory_order_acquire); };
+
+		/// @brief Checks whether no element has been published
+		bool empty() const noexcept { return size() == 0; };
+
+		/// @brief Returns an iterator to the first published element
+		const_iterator begin() const noexcept { return const_iterator(first, 0); };
+
+		/// @brief Returns an iterator to the first published element
+		const_iterator cbegin() const noexcept { return begin(); };
+
+		/// @brief Returns the sentinel for the first slot that is not published
+		std::default_sentinel_t end() const noexcept { return std::default_sentinel; };
+
+		/// @brief Returns the sentinel for the first slot that is not published
+		std::default_sentinel_t cend() const noexcept { return std::default_sentinel; };
+	};
+}
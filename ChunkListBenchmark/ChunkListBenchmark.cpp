@@ -0,0 +1,590 @@
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+#include "../ChunkList/ChunkList.h"
+#include "../ChunkList/ChunkListParallel.h"
+#include "../ChunkList/ConcurrentChunkList.h"
+
+using namespace fefu_laboratory_two;
+
+namespace ChunkListBenchmark
+{
+	/// Appends state.range(0) elements to an empty list. Time per element must
+	/// stay flat as the size grows, i.e. the whole fill is linear.
+	template <int N>
+	void PushBack(benchmark::State& state)
+	{
+		const int count = static_cast<int>(state.range(0));
+		for (auto _ : state)
+		{
+			ChunkList<int, N> list;
+			for (int i = 0; i < count; i++) list.push_back(i);
+			benchmark::DoNotOptimize(list.back());
+		}
+		state.SetItemsProcessed(state.iterations() * count);
+		state.SetComplexityN(count);
+	}
+
+	BENCHMARK_TEMPLATE(PushBack, 16)->RangeMultiplier(8)->Range(1 << 10, 1 << 22)->Complexity(benchmark::oN);
+	BENCHMARK_TEMPLATE(PushBack, 256)->RangeMultiplier(8)->Range(1 << 10, 1 << 22)->Complexity(benchmark::oN);
+
+	/// Loads state.range(0) elements from a vector with the range constructor,
+	/// which fills whole chunks at once. PushBack is the element-wise baseline.
+	template <int N>
+	void RangeConstruct(benchmark::State& state)
+	{
+		std::vector<int> source(state.range(0));
+		for (std::size_t i = 0; i < source.size(); i++) source[i] = static_cast<int>(i);
+		for (auto _ : state)
+		{
+			ChunkList<int, N> list(source.begin(), source.end());
+			benchmark::DoNotOptimize(list.back());
+		}
+		state.SetItemsProcessed(state.iterations() * state.range(0));
+	}
+
+	BENCHMARK_TEMPLATE(PushBack, 256)->Arg(10000000)->Unit(benchmark::kMillisecond);
+	BENCHMARK_TEMPLATE(RangeConstruct, 256)->Arg(10000000)->Unit(benchmark::kMillisecond);
+
+	/// Reads pseudo-random positions of a list of state.range(0) elements.
+	/// Time per lookup must not grow with the size of the list.
+	template <int N>
+	void RandomAt(benchmark::State& state)
+	{
+		const int count = static_cast<int>(state.range(0));
+		ChunkList<int, N> list;
+		for (int i = 0; i < count; i++) list.push_back(i);
+
+		unsigned pos = 1;
+		for (auto _ : state)
+		{
+			pos = pos * 1664525u + 1013904223u;
+			benchmark::DoNotOptimize(list.at(pos % count));
+		}
+		state.SetComplexityN(count);
+	}
+
+	BENCHMARK_TEMPLATE(RandomAt, 16)->RangeMultiplier(8)->Range(1 << 10, 1 << 22)->Complexity(benchmark::o1);
+	BENCHMARK_TEMPLATE(RandomAt, 256)->RangeMultiplier(8)->Range(1 << 10, 1 << 22)->Complexity(benchmark::o1);
+
+	/// Sums a list of state.range(0) elements with a range-based for loop.
+	template <int N>
+	void Traverse(benchmark::State& state)
+	{
+		const int count = static_cast<int>(state.range(0));
+		ChunkList<int, N> list;
+		for (int i = 0; i < count; i++) list.push_back(i);
+
+		for (auto _ : state)
+		{
+			long long sum = 0;
+			for (int x : list) sum += x;
+			benchmark::DoNotOptimize(sum);
+		}
+		state.SetItemsProcessed(state.iterations() * count);
+		state.SetComplexityN(count);
+	}
+
+	BENCHMARK_TEMPLATE(Traverse, 16)->RangeMultiplier(8)->Range(1 << 10, 1 << 22)->Complexity(benchmark::oN);
+	BENCHMARK_TEMPLATE(Traverse, 256)->RangeMultiplier(8)->Range(1 << 10, 1 << 22)->Complexity(benchmark::oN);
+
+	/// Sums the same list newest-first through reverse iterators. Should run
+	/// at the speed of Traverse.
+	template <int N>
+	void ReverseTraverse(benchmark::State& state)
+	{
+		const int count = static_cast<int>(state.range(0));
+		ChunkList<int, N> list;
+		for (int i = 0; i < count; i++) list.push_back(i);
+
+		for (auto _ : state)
+		{
+			long long sum = 0;
+			for (auto it = list.crbegin(); it != list.crend(); ++it) sum += *it;
+			benchmark::DoNotOptimize(sum);
+		}
+		state.SetItemsProcessed(state.iterations() * count);
+		state.SetComplexityN(count);
+	}
+
+	BENCHMARK_TEMPLATE(ReverseTraverse, 16)->RangeMultiplier(8)->Range(1 << 10, 1 << 22)->Complexity(benchmark::oN);
+	BENCHMARK_TEMPLATE(ReverseTraverse, 256)->RangeMultiplier(8)->Range(1 << 10, 1 << 22)->Complexity(benchmark::oN);
+
+	/// Sums a list of state.range(0) elements with the segmented accumulate,
+	/// one tight loop per chunk span. Compare with Traverse.
+	template <int N>
+	void SegmentedAccumulate(benchmark::State& state)
+	{
+		const int count = static_cast<int>(state.range(0));
+		ChunkList<int, N> list;
+		for (int i = 0; i < count; i++) list.push_back(i);
+
+		for (auto _ : state)
+			benchmark::DoNotOptimize(accumulate(list, 0LL));
+		state.SetItemsProcessed(state.iterations() * count);
+		state.SetComplexityN(count);
+	}
+
+	BENCHMARK_TEMPLATE(SegmentedAccumulate, 16)->RangeMultiplier(8)->Range(1 << 10, 1 << 22)->Complexity(benchmark::oN);
+	BENCHMARK_TEMPLATE(SegmentedAccumulate, 256)->RangeMultiplier(8)->Range(1 << 10, 1 << 22)->Complexity(benchmark::oN);
+
+	/// Looks for a value missing from a list of state.range(0) elements,
+	/// through iterators and then through the segmented find.
+	void FindIterators(benchmark::State& state)
+	{
+		const int count = static_cast<int>(state.range(0));
+		ChunkList<int, 256> list;
+		for (int i = 0; i < count; i++) list.push_back(i);
+
+		for (auto _ : state)
+			benchmark::DoNotOptimize(std::find(list.cbegin(), list.cend(), -1));
+		state.SetItemsProcessed(state.iterations() * count);
+	}
+
+	void FindSegmented(benchmark::State& state)
+	{
+		const int count = static_cast<int>(state.range(0));
+		ChunkList<int, 256> list;
+		for (int i = 0; i < count; i++) list.push_back(i);
+
+		for (auto _ : state)
+			benchmark::DoNotOptimize(find(list, -1));
+		state.SetItemsProcessed(state.iterations() * count);
+	}
+
+	BENCHMARK(FindIterators)->Arg(1 << 20);
+	BENCHMARK(FindSegmented)->Arg(1 << 20);
+
+	/// Sums a list of state.range(0) elements chunk by chunk, with the scalar
+	/// kernel or with the dispatched one (AVX2 where available).
+	template <typename T, bool Simd>
+	void Sum(benchmark::State& state)
+	{
+		const int count = static_cast<int>(state.range(0));
+		ChunkList<T, auto_chunk_size<T>> list;
+		for (int i = 0; i < count; i++) list.push_back(static_cast<T>(i % 1000));
+
+		for (auto _ : state)
+		{
+			simd::sum_type<T> result = 0;
+			if constexpr (Simd)
+				result = sum(list);
+			else
+				for (std::span<const T> span : list.chunks())
+					result += simd::scalar::sum(span.data(), span.size());
+			benchmark::DoNotOptimize(result);
+		}
+		state.SetBytesProcessed(state.iterations() * count * sizeof(T));
+	}
+
+	BENCHMARK_TEMPLATE(Sum, int, false)->RangeMultiplier(64)->Range(1 << 12, 1 << 24);
+	BENCHMARK_TEMPLATE(Sum, int, true)->RangeMultiplier(64)->Range(1 << 12, 1 << 24);
+	BENCHMARK_TEMPLATE(Sum, float, false)->RangeMultiplier(64)->Range(1 << 12, 1 << 24);
+	BENCHMARK_TEMPLATE(Sum, float, true)->RangeMultiplier(64)->Range(1 << 12, 1 << 24);
+
+	/// Dot product of two lists of state.range(0) elements, scalar against
+	/// dispatched kernels.
+	template <typename T, bool Simd>
+	void Dot(benchmark::State& state)
+	{
+		const int count = static_cast<int>(state.range(0));
+		ChunkList<T, auto_chunk_size<T>> a;
+		ChunkList<T, auto_chunk_size<T>> b;
+		for (int i = 0; i < count; i++) {
+			a.push_back(static_cast<T>(i % 100));
+			b.push_back(static_cast<T>(i % 7));
+		}
+
+		for (auto _ : state)
+		{
+			simd::sum_type<T> result = 0;
+			if constexpr (Simd)
+				result = dot(a, b);
+			else
+				for (int i = 0; i < count; i += auto_chunk_size<T>)
+					result += simd::scalar::dot(&a[i], &b[i], std::min(auto_chunk_size<T>, count - i));
+			benchmark::DoNotOptimize(result);
+		}
+		state.SetBytesProcessed(state.iterations() * count * 2 * sizeof(T));
+	}
+
+	BENCHMARK_TEMPLATE(Dot, int, false)->Arg(1 << 20);
+	BENCHMARK_TEMPLATE(Dot, int, true)->Arg(1 << 20);
+	BENCHMARK_TEMPLATE(Dot, double, false)->Arg(1 << 20);
+	BENCHMARK_TEMPLATE(Dot, double, true)->Arg(1 << 20);
+
+	/// Counts a value in a list of state.range(0) ints, scalar against
+	/// dispatched kernels.
+	template <bool Simd>
+	void Count(benchmark::State& state)
+	{
+		const int count = static_cast<int>(state.range(0));
+		ChunkList<int, auto_chunk_size<int>> list;
+		for (int i = 0; i < count; i++) list.push_back(i % 10);
+
+		for (auto _ : state)
+		{
+			std::size_t result = 0;
+			if constexpr (Simd)
+				result = fefu_laboratory_two::count(list, 3);
+			else
+				for (std::span<const int> span : list.chunks())
+					result += simd::scalar::count(span.data(), span.size(), 3);
+			benchmark::DoNotOptimize(result);
+		}
+		state.SetBytesProcessed(state.iterations() * count * sizeof(int));
+	}
+
+	BENCHMARK_TEMPLATE(Count, false)->Arg(1 << 20);
+	BENCHMARK_TEMPLATE(Count, true)->Arg(1 << 20);
+
+	/// Reduces and sorts a list of state.range(0) elements on a pool of
+	/// state.range(1) threads. One thread is the serial baseline.
+	void ParallelReduce(benchmark::State& state)
+	{
+		const int count = static_cast<int>(state.range(0));
+		ThreadPool pool(static_cast<unsigned>(state.range(1)));
+		ChunkList<int, auto_chunk_size<int>> list;
+		for (int i = 0; i < count; i++) list.push_back(i % 1000);
+
+		for (auto _ : state)
+			benchmark::DoNotOptimize(reduce(parallel_policy{ &pool }, list, 0LL));
+		state.SetItemsProcessed(state.iterations() * count);
+	}
+
+	void ParallelSort(benchmark::State& state)
+	{
+		const int count = static_cast<int>(state.range(0));
+		ThreadPool pool(static_cast<unsigned>(state.range(1)));
+		ChunkList<int, auto_chunk_size<int>> list(count, 0);
+
+		for (auto _ : state)
+		{
+			state.PauseTiming();
+			unsigned seed = 1;
+			for (int& x : list) x = static_cast<int>(seed = seed * 1103515245 + 12345);
+			state.ResumeTiming();
+			sort(parallel_policy{ &pool }, list);
+			benchmark::DoNotOptimize(list.front());
+		}
+		state.SetItemsProcessed(state.iterations() * count);
+	}
+
+	BENCHMARK(ParallelReduce)->ArgsProduct({ { 1 << 24 }, { 1, 4, 16 } })->UseRealTime();
+	BENCHMARK(ParallelSort)->ArgsProduct({ { 1 << 22 }, { 1, 4, 16 } })->UseRealTime()->Unit(benchmark::kMillisecond);
+
+	/// Compares two equal lists of state.range(0) elements whose chunks are
+	/// split differently, so runs are matched across chunk boundaries.
+	template <int N>
+	void Equal(benchmark::State& state)
+	{
+		const int count = static_cast<int>(state.range(0));
+		ChunkList<int, N> lhs;
+		for (int i = 0; i < count; i++) lhs.push_back(i);
+		ChunkList<int, N> rhs = lhs;
+		rhs.erase(rhs.cbegin() + 1, rhs.cbegin() + 2);
+		rhs.insert(rhs.cbegin() + 1, 1);
+
+		for (auto _ : state)
+			benchmark::DoNotOptimize(lhs == rhs);
+		state.SetItemsProcessed(state.iterations() * count);
+		state.SetComplexityN(count);
+	}
+
+	BENCHMARK_TEMPLATE(Equal, 256)->RangeMultiplier(8)->Range(1 << 10, 1 << 22)->Complexity(benchmark::oN);
+
+	/// Inserts and then erases a block of state.range(1) elements in the
+	/// middle of a list of state.range(0) elements. Only the chunks around
+	/// the middle are touched, so the time must not depend on the list size.
+	template <int N>
+	void MiddleInsertErase(benchmark::State& state)
+	{
+		const int count = static_cast<int>(state.range(0));
+		const int block = static_cast<int>(state.range(1));
+		ChunkList<int, N> list;
+		for (int i = 0; i < count; i++) list.push_back(i);
+
+		for (auto _ : state)
+		{
+			auto it = list.insert(list.cbegin() + count / 2, block, 42);
+			list.erase(it, it + block);
+		}
+		state.SetItemsProcessed(state.iterations() * block);
+	}
+
+	BENCHMARK_TEMPLATE(MiddleInsertErase, 256)->ArgsProduct({ {1 << 12, 1 << 16, 1 << 20}, {1, 64, 1024} });
+
+	/// Element owning a heap buffer that counts how often it is copied or moved.
+	struct Heavy
+	{
+		static inline long long copies = 0;
+		static inline long long moves = 0;
+		std::vector<char> payload;
+
+		explicit Heavy(std::size_t bytes) : payload(bytes) {}
+		Heavy(const Heavy& other) : payload(other.payload) { copies++; }
+		Heavy(Heavy&& other) noexcept : payload(std::move(other.payload)) { moves++; }
+	};
+
+	/// Appends Heavy elements built from a temporary. Reports the copies and
+	/// moves per element that the temporary costs.
+	void PushBackHeavy(benchmark::State& state)
+	{
+		Heavy::copies = Heavy::moves = 0;
+		for (auto _ : state)
+		{
+			ChunkList<Heavy, 64> list;
+			for (int i = 0; i < 1024; i++) list.push_back(Heavy(256));
+			benchmark::DoNotOptimize(list.back());
+		}
+		state.counters["copies"] = benchmark::Counter(static_cast<double>(Heavy::copies), benchmark::Counter::kAvgIterations);
+		state.counters["moves"] = benchmark::Counter(static_cast<double>(Heavy::moves), benchmark::Counter::kAvgIterations);
+	}
+
+	/// Appends Heavy elements constructed in place. Copies and moves must be 0.
+	void EmplaceBackHeavy(benchmark::State& state)
+	{
+		Heavy::copies = Heavy::moves = 0;
+		for (auto _ : state)
+		{
+			ChunkList<Heavy, 64> list;
+			for (int i = 0; i < 1024; i++) list.emplace_back(256);
+			benchmark::DoNotOptimize(list.back());
+		}
+		state.counters["copies"] = benchmark::Counter(static_cast<double>(Heavy::copies), benchmark::Counter::kAvgIterations);
+		state.counters["moves"] = benchmark::Counter(static_cast<double>(Heavy::moves), benchmark::Counter::kAvgIterations);
+	}
+
+	/// Appends move-only elements constructed in place.
+	void EmplaceBackMoveOnly(benchmark::State& state)
+	{
+		for (auto _ : state)
+		{
+			ChunkList<std::unique_ptr<int>, 64> list;
+			for (int i = 0; i < 1024; i++) list.emplace_back(new int(i));
+			benchmark::DoNotOptimize(list.back());
+		}
+	}
+
+	BENCHMARK(PushBackHeavy);
+	BENCHMARK(EmplaceBackHeavy);
+	BENCHMARK(EmplaceBackMoveOnly);
+
+	/// Fills a list of state.range(0) elements and clears it again, so every
+	/// chunk is allocated and freed once per iteration. The list outlives the
+	/// loop, which lets the pool hand the same blocks out again.
+	template <class Alloc>
+	void BuildAndClear(benchmark::State& state, Alloc alloc)
+	{
+		const int count = static_cast<int>(state.range(0));
+		ChunkList<int, 16, Alloc> list(alloc);
+		for (auto _ : state)
+		{
+			for (int i = 0; i < count; i++) list.push_back(i);
+			benchmark::DoNotOptimize(list.back());
+			list.clear();
+		}
+		state.SetItemsProcessed(state.iterations() * count);
+	}
+
+	BENCHMARK_CAPTURE(BuildAndClear, malloc, Allocator<int>())->RangeMultiplier(16)->Range(1 << 10, 1 << 18);
+	BENCHMARK_CAPTURE(BuildAndClear, pool, PoolAllocator<int>())->RangeMultiplier(16)->Range(1 << 10, 1 << 18);
+
+	/// Builds a list in a fresh monotonic arena and drops it. Chunks are never
+	/// freed one by one, the arena releases its slabs in one go.
+	void BuildArena(benchmark::State& state)
+	{
+		const int count = static_cast<int>(state.range(0));
+		for (auto _ : state)
+		{
+			PoolAllocator<int> arena(true);
+			ChunkList<int, 16, PoolAllocator<int>> list(arena);
+			for (int i = 0; i < count; i++) list.push_back(i);
+			benchmark::DoNotOptimize(list.back());
+		}
+		state.SetItemsProcessed(state.iterations() * count);
+	}
+
+	void BuildMalloc(benchmark::State& state)
+	{
+		const int count = static_cast<int>(state.range(0));
+		for (auto _ : state)
+		{
+			ChunkList<int, 16> list;
+			for (int i = 0; i < count; i++) list.push_back(i);
+			benchmark::DoNotOptimize(list.back());
+		}
+		state.SetItemsProcessed(state.iterations() * count);
+	}
+
+	BENCHMARK(BuildMalloc)->RangeMultiplier(16)->Range(1 << 10, 1 << 18);
+	BENCHMARK(BuildArena)->RangeMultiplier(16)->Range(1 << 10, 1 << 18);
+
+	/// Takes a read-only view of a list of state.range(0) elements and writes
+	/// one element per chunk of every eighth chunk, as a writer editing a list
+	/// under readers would. Snapshot shares the chunks and copies the eighth it
+	/// writes, DeepCopy copies the whole list up front.
+	void SnapshotAndWrite(benchmark::State& state)
+	{
+		const int count = static_cast<int>(state.range(0));
+		ChunkList<int, 256> list(count, 1);
+		for (auto _ : state)
+		{
+			auto view = list.snapshot();
+			for (int i = 0; i < count; i += 256 * 8) list[i]++;
+			benchmark::DoNotOptimize(view.size());
+		}
+		state.SetItemsProcessed(state.iterations() * count);
+	}
+
+	void DeepCopyAndWrite(benchmark::State& state)
+	{
+		const int count = static_cast<int>(state.range(0));
+		ChunkList<int, 256> list(count, 1);
+		for (auto _ : state)
+		{
+			ChunkList<int, 256> view(list);
+			for (int i = 0; i < count; i += 256 * 8) list[i]++;
+			benchmark::DoNotOptimize(view.size());
+		}
+		state.SetItemsProcessed(state.iterations() * count);
+	}
+
+	BENCHMARK(SnapshotAndWrite)->RangeMultiplier(16)->Range(1 << 12, 1 << 20);
+	BENCHMARK(DeepCopyAndWrite)->RangeMultiplier(16)->Range(1 << 12, 1 << 20);
+
+	/// Element of Size bytes for the chunk size sweep
+	template <std::size_t Size>
+	struct Blob
+	{
+		int key = 0;
+		char bytes[Size - sizeof(int)] = {};
+
+		Blob() = default;
+		Blob(int key) : key(key) {}
+	};
+
+	/// Working set of every sweep list, so that small and large elements are
+	/// compared at the same memory footprint.
+	constexpr std::size_t sweep_bytes = 16 << 20;
+
+	template <class T, auto Chunk>
+	ChunkList<T, Chunk> make_sweep_list()
+	{
+		ChunkList<T, Chunk> list;
+		for (int i = 0; i < static_cast<int>(sweep_bytes / sizeof(T)); i++) list.emplace_back(i);
+		return list;
+	}
+
+	/// Fills a list with sweep_bytes of elements.
+	template <class T, auto Chunk>
+	void SweepPushBack(benchmark::State& state)
+	{
+		const int count = static_cast<int>(sweep_bytes / sizeof(T));
+		for (auto _ : state)
+		{
+			ChunkList<T, Chunk> list;
+			for (int i = 0; i < count; i++) list.emplace_back(i);
+			benchmark::DoNotOptimize(list.back());
+		}
+		state.SetItemsProcessed(state.iterations() * count);
+	}
+
+	/// Reads the key of every element.
+	template <class T, auto Chunk>
+	void SweepTraverse(benchmark::State& state)
+	{
+		const auto list = make_sweep_list<T, Chunk>();
+		for (auto _ : state)
+		{
+			long long sum = 0;
+			for (const T& value : list) sum += value.key;
+			benchmark::DoNotOptimize(sum);
+		}
+		state.SetItemsProcessed(state.iterations() * list.size());
+	}
+
+	/// Reads pseudo-random positions.
+	template <class T, auto Chunk>
+	void SweepRandomAt(benchmark::State& state)
+	{
+		const auto list = make_sweep_list<T, Chunk>();
+		unsigned pos = 1;
+		for (auto _ : state)
+		{
+			pos = pos * 1664525u + 1013904223u;
+			benchmark::DoNotOptimize(list.at(pos % list.size()).key);
+		}
+		state.SetItemsProcessed(state.iterations());
+	}
+
+	/// Inserts one element in the middle and erases it again.
+	template <class T, auto Chunk>
+	void SweepMiddleInsertErase(benchmark::State& state)
+	{
+		auto list = make_sweep_list<T, Chunk>();
+		const int middle = static_cast<int>(list.size() / 2);
+		for (auto _ : state)
+		{
+			auto it = list.emplace(list.cbegin() + middle, 42);
+			list.erase(it);
+		}
+		state.SetItemsProcessed(state.iterations());
+	}
+
+	/// Registers the sweep of element type T over chunk blocks of each of
+	/// Bytes, as ChunkSizeSweep/Operation/element size/block bytes.
+	template <class T, std::size_t... Bytes>
+	bool register_sweep()
+	{
+		auto add = [](const char* operation, std::size_t bytes, void (*run)(benchmark::State&)) {
+			std::string name = std::string("ChunkSizeSweep/") + operation + "/" + std::to_string(sizeof(T)) + "B/" + std::to_string(bytes);
+			benchmark::RegisterBenchmark(name.c_str(), run);
+		};
+		(add("PushBack", Bytes, SweepPushBack<T, auto_chunk<Bytes>>), ...);
+		(add("Traverse", Bytes, SweepTraverse<T, auto_chunk<Bytes>>), ...);
+		(add("RandomAt", Bytes, SweepRandomAt<T, auto_chunk<Bytes>>), ...);
+		(add("MiddleInsertErase", Bytes, SweepMiddleInsertErase<T, auto_chunk<Bytes>>), ...);
+		return true;
+	}
+
+	const bool sweep_registered = register_sweep<Blob<8>, 512, 1024, 4096, 16384, 65536>()
+		&& register_sweep<Blob<64>, 512, 1024, 4096, 16384, 65536>()
+		&& register_sweep<Blob<512>, 1024, 4096, 16384, 65536, 262144>();
+
+	/// Every benchmark thread appends to one shared list: the lock-free
+	/// ConcurrentChunkList against a ChunkList behind a mutex.
+	ConcurrentChunkList<int, 256>* concurrent_list = nullptr;
+	ChunkList<int, 256>* locked_list = nullptr;
+	std::mutex locked_mutex;
+
+	void ConcurrentPushBack(benchmark::State& state)
+	{
+		if (state.thread_index() == 0) concurrent_list = new ConcurrentChunkList<int, 256>();
+		for (auto _ : state)
+			concurrent_list->push_back(state.thread_index());
+		if (state.thread_index() == 0) delete concurrent_list;
+		state.SetItemsProcessed(state.iterations());
+	}
+
+	void LockedPushBack(benchmark::State& state)
+	{
+		if (state.thread_index() == 0) locked_list = new ChunkList<int, 256>();
+		for (auto _ : state)
+		{
+			std::lock_guard<std::mutex> lock(locked_mutex);
+			locked_list->push_back(state.thread_index());
+		}
+		if (state.thread_index() == 0) delete locked_list;
+		state.SetItemsProcessed(state.iterations());
+	}
+
+	BENCHMARK(ConcurrentPushBack)->ThreadRange(1, 16)->UseRealTime();
+	BENCHMARK(LockedPushBack)->ThreadRange(1, 16)->UseRealTime();
+}
+
+BENCHMARK_MAIN();
@@ -0,0 +1,287 @@
+/// Compares ChunkList with std::vector, std::deque and std::list on the
+/// common container operations, for several chunk sizes and element types.
+/// Benchmarks are named Operation/Container/size, e.g.
+/// Iterate/ChunkList<int,256>/16384, so results can be filtered and diffed.
+///
+/// Built by the CMake project when Google Benchmark is installed:
+///   cmake -S . -B build -DCMAKE_BUILD_TYPE=Native && cmake --build build
+///   build/ContainerComparison --benchmark_filter=Iterate
+/// Results are written to container_comparison.json unless --benchmark_out
+/// names another file; keep one per release to track regressions.
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <iterator>
+#include <list>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "../ChunkList/ChunkList.h"
+
+using namespace fefu_laboratory_two;
+
+namespace ChunkListBenchmark
+{
+	/// Element that fills a cache line and is copied by value.
+	struct Payload {
+		std::int64_t key = 0;
+		char bytes[56] = {};
+
+		friend bool operator==(const Payload&, const Payload&) = default;
+	};
+
+	/// Values pushed by the benchmarks: distinct, and strings long enough to
+	/// live on the heap.
+	template <class T>
+	std::vector<T> make_values(int count)
+	{
+		std::vector<T> values(count);
+		for (int i = 0; i < count; i++) {
+			if constexpr (std::is_same_v<T, std::string>)
+				values[i] = "element number " + std::to_string(i) + " of the list";
+			else if constexpr (std::is_same_v<T, Payload>)
+				values[i].key = i;
+			else
+				values[i] = static_cast<T>(i);
+		}
+		return values;
+	}
+
+	/// Number folded over all elements when iterating, so that every element is
+	/// actually read.
+	template <class T>
+	long long weight(const T& value)
+	{
+		if constexpr (std::is_same_v<T, std::string>)
+			return static_cast<long long>(value.size());
+		else if constexpr (std::is_same_v<T, Payload>)
+			return value.key;
+		else
+			return static_cast<long long>(value);
+	}
+
+	template <class C>
+	C make_container(int count)
+	{
+		auto values = make_values<typename C::value_type>(count);
+		return C(values.begin(), values.end());
+	}
+
+	template <class C>
+	constexpr bool has_random_access = std::random_access_iterator<typename C::iterator>;
+
+	template <class C>
+	constexpr bool has_push_front = requires(C& c, const typename C::value_type& value) { c.push_front(value); };
+
+	/// Appends state.range(0) elements to an empty container.
+	template <class C>
+	void PushBack(benchmark::State& state)
+	{
+		const int count = static_cast<int>(state.range(0));
+		auto values = make_values<typename C::value_type>(count);
+		for (auto _ : state)
+		{
+			C c;
+			for (const auto& value : values) c.push_back(value);
+			benchmark::DoNotOptimize(c.back());
+		}
+		state.SetItemsProcessed(state.iterations() * count);
+	}
+
+	/// Prepends state.range(0) elements to an empty container.
+	template <class C>
+	void PushFront(benchmark::State& state)
+	{
+		const int count = static_cast<int>(state.range(0));
+		auto values = make_values<typename C::value_type>(count);
+		for (auto _ : state)
+		{
+			C c;
+			for (const auto& value : values) c.push_front(value);
+			benchmark::DoNotOptimize(c.front());
+		}
+		state.SetItemsProcessed(state.iterations() * count);
+	}
+
+	/// Uses a container of state.range(0) elements as a FIFO queue: pushes one
+	/// element at the back and pops one at the front.
+	template <class C>
+	void Queue(benchmark::State& state)
+	{
+		const int count = static_cast<int>(state.range(0));
+		C c = make_container<C>(count);
+		const auto value = make_values<typename C::value_type>(1).front();
+		for (auto _ : state)
+		{
+			c.push_back(value);
+			c.pop_front();
+		}
+		benchmark::DoNotOptimize(c.front());
+		state.SetItemsProcessed(state.iterations());
+	}
+
+	/// Reads pseudo-random positions with bounds-checked at.
+	template <class C>
+	void RandomAt(benchmark::State& state)
+	{
+		const int count = static_cast<int>(state.range(0));
+		const C c = make_container<C>(count);
+		unsigned pos = 1;
+		for (auto _ : state)
+		{
+			pos = pos * 1664525u + 1013904223u;
+			benchmark::DoNotOptimize(c.at(pos % count));
+		}
+		state.SetItemsProcessed(state.iterations());
+	}
+
+	/// Reads every element with a range-based for loop.
+	template <class C>
+	void Iterate(benchmark::State& state)
+	{
+		const int count = static_cast<int>(state.range(0));
+		const C c = make_container<C>(count);
+		for (auto _ : state)
+		{
+			long long sum = 0;
+			for (const auto& value : c) sum += weight(value);
+			benchmark::DoNotOptimize(sum);
+		}
+		state.SetItemsProcessed(state.iterations() * count);
+	}
+
+	/// Inserts one element in the middle and erases it again. Reaching the
+	/// middle is part of the cost, which is linear for std::list.
+	template <class C>
+	void MiddleInsertErase(benchmark::State& state)
+	{
+		const int count = static_cast<int>(state.range(0));
+		C c = make_container<C>(count);
+		const auto value = make_values<typename C::value_type>(1).front();
+		for (auto _ : state)
+		{
+			auto it = c.insert(std::next(c.cbegin(), count / 2), value);
+			c.erase(it);
+		}
+		state.SetItemsProcessed(state.iterations());
+	}
+
+	/// Copy-constructs a container of state.range(0) elements.
+	template <class C>
+	void Copy(benchmark::State& state)
+	{
+		const int count = static_cast<int>(state.range(0));
+		const C c = make_container<C>(count);
+		for (auto _ : state)
+		{
+			C copy(c);
+			benchmark::DoNotOptimize(copy.back());
+		}
+		state.SetItemsProcessed(state.iterations() * count);
+	}
+
+	/// Compares two equal containers, the worst case for ==.
+	template <class C>
+	void Compare(benchmark::State& state)
+	{
+		const int count = static_cast<int>(state.range(0));
+		const C lhs = make_container<C>(count);
+		const C rhs = make_container<C>(count);
+		for (auto _ : state)
+			benchmark::DoNotOptimize(lhs == rhs);
+		state.SetItemsProcessed(state.iterations() * count);
+	}
+
+	/// Clears a container of state.range(0) elements. Refilling it is not timed.
+	template <class C>
+	void Clear(benchmark::State& state)
+	{
+		const int count = static_cast<int>(state.range(0));
+		const C source = make_container<C>(count);
+		for (auto _ : state)
+		{
+			state.PauseTiming();
+			C c(source);
+			state.ResumeTiming();
+			c.clear();
+			benchmark::DoNotOptimize(c.size());
+		}
+		state.SetItemsProcessed(state.iterations() * count);
+	}
+
+	/// Grows an empty container to state.range(0) default elements and shrinks
+	/// it back to empty.
+	template <class C>
+	void Resize(benchmark::State& state)
+	{
+		const int count = static_cast<int>(state.range(0));
+		for (auto _ : state)
+		{
+			C c;
+			c.resize(count);
+			benchmark::DoNotOptimize(c.back());
+			c.resize(0);
+			benchmark::DoNotOptimize(c.size());
+		}
+		state.SetItemsProcessed(state.iterations() * count);
+	}
+
+	/// Registers every operation the container provides, named after the
+	/// operation and then name.
+	template <class C>
+	void register_container(const std::string& name)
+	{
+		auto add = [&name](const char* operation, void (*run)(benchmark::State&)) {
+			benchmark::RegisterBenchmark((std::string(operation) + "/" + name).c_str(), run)
+				->Arg(1 << 8)->Arg(1 << 14)->Arg(1 << 20);
+		};
+		add("PushBack", PushBack<C>);
+		if constexpr (has_push_front<C>) {
+			add("PushFront", PushFront<C>);
+			add("Queue", Queue<C>);
+		}
+		if constexpr (has_random_access<C>)
+			add("RandomAt", RandomAt<C>);
+		add("Iterate", Iterate<C>);
+		add("MiddleInsertErase", MiddleInsertErase<C>);
+		add("Copy", Copy<C>);
+		add("Compare", Compare<C>);
+		add("Clear", Clear<C>);
+		add("Resize", Resize<C>);
+	}
+
+	template <class T>
+	void register_element(const std::string& type)
+	{
+		register_container<ChunkList<T, 16>>("ChunkList<" + type + ",16>");
+		register_container<ChunkList<T, 256>>("ChunkList<" + type + ",256>");
+		register_container<ChunkList<T, auto_chunk<>>>("ChunkList<" + type + ",auto>");
+		register_container<std::vector<T>>("vector<" + type + ">");
+		register_container<std::deque<T>>("deque<" + type + ">");
+		register_container<std::list<T>>("list<" + type + ">");
+	}
+}
+
+int main(int argc, char** argv)
+{
+	using namespace ChunkListBenchmark;
+	register_element<int>("int");
+	register_element<Payload>("Payload");
+	register_element<std::string>("string");
+
+	std::vector<char*> args(argv, argv + argc);
+	std::string out = "--benchmark_out=container_comparison.json";
+	std::string format = "--benchmark_out_format=json";
+	if (std::none_of(args.begin() + 1, args.end(), [](const char* arg) { return std::string_view(arg).starts_with("--benchmark_out="); })) {
+		args.push_back(out.data());
+		args.push_back(format.data());
+	}
+	int count = static_cast<int>(args.size());
+	benchmark::Initialize(&count, args.data());
+	if (benchmark::ReportUnrecognizedArguments(count, args.data()))
+		return 1;
+	benchmark::RunSpecifiedBenchmarks();
+	benchmark::Shutdown();
+	return 0;
+}
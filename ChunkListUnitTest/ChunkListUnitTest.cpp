@@ -1,351 +1,1422 @@
-#include "pch.h"
-#include "CppUnitTest.h"
+﻿#include <gtest/gtest.h>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <numeric>
+#include <string>
+#include <thread>
 #include <vector>
 #include "../ChunkList/ChunkList.h"
+#include "../ChunkList/ChunkListParallel.h"
+#include "../ChunkList/ConcurrentChunkList.h"
 
 using namespace fefu_laboratory_two;
-using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 
 namespace ChunkListUnitTest
 {
-	TEST_CLASS(Constructors)
+	TEST(Constructors, DefaultConstructor)
 	{
-	public:
-		TEST_METHOD(DefaultConstructor)
-		{
-			ChunkList<int, 12> list;
+		ChunkList<int, 12> list;
 
 
-			Assert::IsTrue(list.empty() == true);
-			Assert::IsTrue(list.size() == 0);
-		}
+		EXPECT_TRUE(list.empty() == true);
+		EXPECT_TRUE(list.size() == 0);
+	}
+
+	TEST(Constructors, CopyConstructor)
+	{
+		ChunkList<int, 10> list1;
+		for (int i = 0; i < 10; i++) list1.push_back(i);
 
-		TEST_METHOD(CopyConstructor)
-		{
-			ChunkList<int, 10> list1;
-			for (int i = 0; i < 10; i++) list1.push_back(i);
 
+		auto list2 = list1;
 
-			auto list2 = list1;
+		
+		EXPECT_TRUE(list1 == list2);
+	}
 
-			
-			Assert::IsTrue(list1 == list2);
+	TEST(Constructors, InitializerListConstructor)
+	{
+		ChunkList<int, 10> list1 = { 1,2,3,4,5 };
+		ChunkList<int, 10> list2;
+		for (int i = 1; i <= 5; i++) {
+			list2.push_back(i);
 		}
 
-		TEST_METHOD(InitializerListConstructor)
-		{
-			ChunkList<int, 10> list1 = { 1,2,3,4,5 };
-			ChunkList<int, 10> list2;
-			for (int i = 1; i <= 5; i++) {
-				list2.push_back(i);
-			}
 
+		EXPECT_TRUE(list1 == list2);
+	}
 
-			Assert::IsTrue(list1 == list2);
-		}
+	TEST(Constructors, IteratorsConstructor)
+	{
+		std::vector<int> v = { 1,2,3,4,5,6,7 };
+		auto first = v.begin();
+		auto last = v.end();
+		ChunkList<int, 10> list1(first, last);
+		ChunkList<int, 10> list2 = { 1,2,3,4,5,6,7 };
 
-		TEST_METHOD(IteratorsConstructor)
-		{
-			std::vector<int> v = { 1,2,3,4,5,6,7 };
-			auto first = v.begin();
-			auto last = v.end();
-			ChunkList<int, 10> list1(first, last);
-			ChunkList<int, 10> list2 = { 1,2,3,4,5,6,7 };
 
+		EXPECT_TRUE(list1 == list2);
+	}
 
-			Assert::IsTrue(list1 == list2);
-		}
+	TEST(Constructors, BulkConstructAndAssign)
+	{
+		std::vector<int> v(1000);
+		for (int i = 0; i < 1000; i++) v[i] = i;
+
+		ChunkList<int, 16> list(v.begin(), v.end());
+		EXPECT_TRUE(list.size() == 1000);
+		EXPECT_EQ(0, list.front());
+		EXPECT_EQ(517, list[517]);
+		EXPECT_EQ(999, list.back());
+
+		ChunkList<int, 16> filled(100, 3);
+		EXPECT_TRUE(filled.size() == 100);
+		EXPECT_EQ(3, filled[99]);
+
+		filled.resize(250);
+		EXPECT_EQ(3, filled[99]);
+		EXPECT_EQ(0, filled[249]);
+		filled.resize(40, 9);
+		EXPECT_TRUE(filled.size() == 40);
+		EXPECT_EQ(3, filled.back());
+
+		filled.assignIt(v.begin() + 10, v.begin() + 30);
+		EXPECT_TRUE(filled.size() == 20);
+		EXPECT_EQ(29, filled.back());
+		filled = { 5, 6 };
+		EXPECT_TRUE(filled.size() == 2);
+		EXPECT_EQ(6, filled.back());
+		filled.assignIt(v.begin(), v.begin());
+		EXPECT_TRUE(filled.empty());
+
+		ChunkList<std::string, 4> strings(10, std::string(20, 's'));
+		strings.resize(3);
+		strings.resize(6, "t");
+		EXPECT_TRUE(strings[2] == std::string(20, 's'));
+		EXPECT_TRUE(strings[5] == "t");
+	}
+
+	TEST(Constructors, Assign)
+	{
+		ChunkList<int, 10> list1;
+		ChunkList<int, 10> list2;
+		for (int i = 0; i < 10; i++) list1.push_back(7);
 
-		TEST_METHOD(Assign)
-		{
-			ChunkList<int, 10> list1;
-			ChunkList<int, 10> list2;
-			for (int i = 0; i < 10; i++) list1.push_back(7);
 
+		list2.assign(10, 7);
 
-			list2.assign(10, 7);
 
+		EXPECT_TRUE(list1 == list2);
+	}
 
-			Assert::IsTrue(list1 == list2);
-		}
+	TEST(Constructors, AssignIterators)
+	{
+		std::vector<int> v = { 1,2,3,4,5,6,7 };
+		auto first = v.begin();
+		auto last = v.end();
+		ChunkList<int, 10> list1;
+		ChunkList<int, 10> list2;
+		for (int i = 1; i <= 7; i++) list2.push_back(i);
 
-		TEST_METHOD(AssignIterators)
-		{
-			std::vector<int> v = { 1,2,3,4,5,6,7 };
-			auto first = v.begin();
-			auto last = v.end();
-			ChunkList<int, 10> list1;
-			ChunkList<int, 10> list2;
-			for (int i = 1; i <= 7; i++) list2.push_back(i);
 
+		list1.assignIt(first, last);
 
-			list1.assignIt(first, last);
 
+		EXPECT_TRUE(list1 == list2);
+	}
 
-			Assert::IsTrue(list1 == list2);
-		}
+	TEST(Constructors, AssignInitList)
+	{
+		ChunkList<int, 10> list1;
+		ChunkList<int, 10> list2 = { 1,2,3,4,5 };
 
-		TEST_METHOD(AssignInitList)
-		{
-			ChunkList<int, 10> list1;
-			ChunkList<int, 10> list2 = { 1,2,3,4,5 };
 
+		list1.assign({ 1,2,3,4,5 });
 
-			list1.assign({ 1,2,3,4,5 });
 
+		EXPECT_TRUE(list1 == list2);
+	}
 
-			Assert::IsTrue(list1 == list2);
-		}
+	TEST(Constructors, AssignmentOperator)
+	{
+		ChunkList<int, 10> list1;
+		ChunkList<int, 10> list2 = { 1,2,3,4,5 };
 
-		TEST_METHOD(AssignmentOperator)
-		{
-			ChunkList<int, 10> list1;
-			ChunkList<int, 10> list2 = { 1,2,3,4,5 };
 
+		list1 = { 1,2,3,4,5 };
 
-			list1 = { 1,2,3,4,5 };
 
+		EXPECT_TRUE(list1 == list2);
+	}
 
-			Assert::IsTrue(list1 == list2);
-		}
-	};
+	TEST(Constructors, MoveAndCopyAssignment)
+	{
+		static_assert(std::is_nothrow_move_constructible_v<ChunkList<std::string, 4>>);
+		static_assert(std::is_nothrow_move_assignable_v<ChunkList<std::string, 4>>);
+		static_assert(std::is_nothrow_swappable_v<ChunkList<std::string, 4>>);
+
+		ChunkList<std::string, 4> source(10, std::string(20, 'a'));
+		const std::string* element = &source[7];
+		ChunkList<std::string, 4> moved(std::move(source));
+		EXPECT_TRUE(source.empty());
+		EXPECT_TRUE(&moved[7] == element);
+		source.push_back("reused");
+		EXPECT_TRUE(source.size() == 1);
+
+		source = std::move(moved);
+		EXPECT_TRUE(moved.empty());
+		EXPECT_TRUE(&source[7] == element);
+
+		std::vector<ChunkList<std::string, 4>> lists;
+		lists.push_back(std::move(source));
+		for (int i = 0; i < 20; i++) lists.emplace_back(3, "x");
+		EXPECT_TRUE(&lists[0][7] == element);
+
+		swap(lists[0], lists[1]);
+		EXPECT_TRUE(&lists[1][7] == element);
+		EXPECT_TRUE(lists[0].size() == 3);
+
+		ChunkList<int, 4> ints;
+		for (int i = 0; i < 30; i++) ints.push_back(i);
+		ints.erase(ints.cbegin() + 3, ints.cbegin() + 9);
+		ChunkList<int, 4> smaller = { 7, 8, 9 };
+		ChunkList<int, 4> larger(50, 1);
+		larger = ints;
+		smaller = ints;
+		EXPECT_TRUE(larger == ints);
+		EXPECT_TRUE(smaller == ints);
+		larger = larger;
+		EXPECT_TRUE(larger == ints);
+
+		lists[2] = lists[1];
+		EXPECT_TRUE(lists[2].size() == 10);
+		EXPECT_TRUE(lists[2][9] == std::string(20, 'a'));
+	}
+
+	TEST(ElementAccess, At)
+	{
+		ChunkList<int, 10> list;
+		for (int i = 0; i < 15; i++) list.push_back(i);
+		
+
+		for (int i = 0; i < 15; i++) EXPECT_EQ(i, list.at(i));
+	}
 
-	TEST_CLASS(ElementAccess)
+	TEST(ElementAccess, Indexation)
 	{
-	public:
-		TEST_METHOD(At)
-		{
-			ChunkList<int, 10> list;
-			for (int i = 0; i < 15; i++) list.push_back(i);
-			
+		ChunkList<int, 10> list;
+		for (int i = 0; i < 15; i++) list.push_back(i);
 
-			for (int i = 0; i < 15; i++) Assert::AreEqual(i, list.at(i));
-		}
 
-		TEST_METHOD(Indexation)
-		{
-			ChunkList<int, 10> list;
-			for (int i = 0; i < 15; i++) list.push_back(i);
+		for (int i = 0; i < 15; i++) EXPECT_EQ(i, list.at(i));
+	}
 
+	TEST(ElementAccess, AtManyChunks)
+	{
+		ChunkList<int, 7> list;
+		for (int i = 0; i < 1000; i++) list.push_back(i * 3);
+		for (int i = 0; i < 300; i++) list.pop_back();
 
-			for (int i = 0; i < 15; i++) Assert::AreEqual(i, list.at(i));
-		}
 
-		TEST_METHOD(Front)
-		{
-			ChunkList<int, 10> list = {42, 1, 5, 7, 4, 1};
-			
+		for (int i = 699; i >= 0; i -= 13) EXPECT_EQ(i * 3, list[i]);
+		EXPECT_EQ(699 * 3, list.at(699));
+		EXPECT_THROW(list.at(700), std::out_of_range);
+	}
 
-			Assert::IsTrue(list.front() == 42);
-		}
+	TEST(ElementAccess, Front)
+	{
+		ChunkList<int, 10> list = {42, 1, 5, 7, 4, 1};
+		
 
-		TEST_METHOD(Back)
-		{
-			ChunkList<int, 10> list = {1, 1, 5, 8, 0, 2, 5, 7, 42};
+		EXPECT_TRUE(list.front() == 42);
+	}
 
+	TEST(ElementAccess, Back)
+	{
+		ChunkList<int, 10> list = {1, 1, 5, 8, 0, 2, 5, 7, 42};
 
-			Assert::IsTrue(list.back() == 42);
-		}
-	};
 
-	TEST_CLASS(Iterator) {
-		TEST_METHOD(IteratorsForeach) {
-			ChunkList<int, 10> list = { 1, 4, 7, 8, 9, 13, 45 ,7, 9, 2 };
-			int* arr = new int[10] { 1, 4, 7, 8, 9, 13, 45, 7, 9, 2 };
+		EXPECT_TRUE(list.back() == 42);
+	}
 
-			int i = 0;
-			for (auto e : list) Assert::IsTrue(arr[i++] == e);
-		}
+	TEST(Iterator, IteratorsForeach) {
+		ChunkList<int, 10> list = { 1, 4, 7, 8, 9, 13, 45 ,7, 9, 2 };
+		int arr[10] = { 1, 4, 7, 8, 9, 13, 45, 7, 9, 2 };
 
-		TEST_METHOD(IteratorsCompare)
-		{
-			ChunkList<int, 10> list = { 1, 4, 7, 8, 9, 13, 45 ,7, 9, 2 };
-			int* arr = new int[10] { 1, 4, 7, 8, 9, 13, 45, 7, 9, 2 };
-
-			auto it1 = list.begin();
-			auto it2 = list.begin();
-
-			Assert::IsTrue(it1 == it2);
-			Assert::IsTrue(it1 >= it2);
-			Assert::IsTrue(it1 <= it2);
-			
-			it1++;
-			Assert::IsTrue(it1 > it2);
-			it2 += 7;
-			Assert::IsTrue(it2 > it1);
-		}
-	};
+		int i = 0;
+		for (auto e : list) EXPECT_TRUE(arr[i++] == e);
+	}
+
+	TEST(Iterator, IteratorsCompare)
+	{
+		ChunkList<int, 10> list = { 1, 4, 7, 8, 9, 13, 45 ,7, 9, 2 };
+
+		auto it1 = list.begin();
+		auto it2 = list.begin();
+
+		EXPECT_TRUE(it1 == it2);
+		EXPECT_TRUE(it1 >= it2);
+		EXPECT_TRUE(it1 <= it2);
+		
+		it1++;
+		EXPECT_TRUE(it1 > it2);
+		it2 += 7;
+		EXPECT_TRUE(it2 > it1);
+	}
+
+	TEST(Iterator, IteratorsTraverseChunks)
+	{
+		static_assert(std::random_access_iterator<ChunkList<int, 4>::iterator>);
+		static_assert(std::random_access_iterator<ChunkList<int, 4>::const_iterator>);
 
-	TEST_CLASS(Capacity) {
-		TEST_METHOD(CapacityEmpty) {
-			ChunkList<int, 11> list;
+		ChunkList<int, 4> list;
+		for (int i = 0; i < 23; i++) list.push_back(i);
 
+		int i = 0;
+		for (auto it = list.begin(); it != list.end(); ++it) EXPECT_EQ(i++, *it);
+		EXPECT_EQ(23, i);
 
-			Assert::IsTrue(list.empty() == true);
-			Assert::IsTrue(list.size() == 0);
-			Assert::IsTrue(list.max_size() == 0);
-		}
+		auto it = list.end();
+		while (it != list.begin()) EXPECT_EQ(--i, *--it);
 
-		TEST_METHOD(CapacityNonEmpty)
-		{
-			ChunkList<int, 4> list = {1, 2, 3, 4, 5, 6, 7};
+		ChunkList<int, 4>::const_iterator cit = list.begin() + 9;
+		EXPECT_TRUE(cit == list.cbegin() + 9);
+		EXPECT_EQ(9, *cit);
+		EXPECT_EQ(17, cit[8]);
+		EXPECT_EQ(3, *(cit - 6));
+		EXPECT_TRUE(list.cend() - cit == 14);
+	}
+
+	TEST(Iterator, ReverseIterators)
+	{
+		ChunkList<int, 4> list;
+		for (int i = 0; i < 23; i++) list.push_back(i);
+		list.erase(list.cbegin() + 5, list.cbegin() + 7);
+		list.insert(list.cbegin() + 10, 3, -1);
+
+		std::vector<int> expected(list.begin(), list.end());
+		std::vector<int> reversed(list.rbegin(), list.rend());
+		EXPECT_TRUE(std::vector<int>(expected.rbegin(), expected.rend()) == reversed);
+
+		const ChunkList<int, 4>& view = list;
+		EXPECT_EQ(22, *view.rbegin());
+		EXPECT_EQ(0, *(view.crend() - 1));
+		EXPECT_TRUE(view.crend() - view.crbegin() == 24);
+		EXPECT_EQ(-1, view.crbegin()[13]);
+
+		*list.rbegin() = 100;
+		EXPECT_EQ(100, list.back());
+
+		ChunkList<int, 4> empty;
+		EXPECT_TRUE(empty.rbegin() == empty.rend());
+	}
+
+	TEST(Capacity, CapacityEmpty) {
+		ChunkList<int, 11> list;
+
+
+		EXPECT_TRUE(list.empty() == true);
+		EXPECT_TRUE(list.size() == 0);
+		EXPECT_TRUE(list.capacity() == 0);
+		EXPECT_TRUE(list.max_size() >= (1u << 29));
+	}
+
+	TEST(Capacity, CapacityNonEmpty)
+	{
+		ChunkList<int, 4> list = {1, 2, 3, 4, 5, 6, 7};
 
 
-			Assert::IsTrue(list.size() == 7);
-			Assert::IsTrue(list.max_size() == 8);
+		EXPECT_TRUE(list.size() == 7);
+		EXPECT_TRUE(list.capacity() == 8);
+		EXPECT_TRUE(list.max_size() > list.capacity());
+	}
+
+	TEST(Capacity, Stats)
+	{
+		ChunkList<std::string, 8> list;
+		chunk_stats empty = list.stats();
+		EXPECT_TRUE(empty.chunks == 0 && empty.size == 0 && empty.chunk_bytes == 0);
+		EXPECT_TRUE(empty.allocated_bytes == sizeof(list));
+
+		for (int i = 0; i < 100; i++) list.push_back(std::to_string(i));
+		list.push_front("front");
+		list.erase(list.cbegin() + 40, list.cbegin() + 45);
+		chunk_stats stats = list.stats();
+		EXPECT_TRUE(stats.size == 96);
+		EXPECT_EQ(stats.chunks, static_cast<std::size_t>(std::ranges::distance(list.chunks())));
+		EXPECT_TRUE(stats.capacity == stats.chunks * 8 && stats.capacity == list.capacity());
+		EXPECT_TRUE(stats.wasted_slots == stats.capacity - 96);
+		EXPECT_TRUE(stats.chunk_bytes == stats.chunks * decltype(list)::chunk_bytes);
+		EXPECT_TRUE(stats.directory_bytes >= stats.chunks * (sizeof(void*) + sizeof(int)));
+		EXPECT_TRUE(stats.allocated_bytes == stats.chunk_bytes + stats.directory_bytes + stats.object_bytes);
+
+		std::array<std::size_t, 8> fill{};
+		for (auto chunk : list.chunks())
+			fill[chunk.empty() ? 0 : (chunk.size() - 1)]++;
+		EXPECT_TRUE(stats.fill == fill);
+		EXPECT_TRUE(stats.fill[7] >= 10);
+		EXPECT_TRUE(stats.fill[0] == 1);
+
+		EXPECT_TRUE(stats.chunk_allocations - stats.chunk_frees == stats.chunks);
+		list.clear();
+		stats = list.stats();
+		EXPECT_TRUE(stats.chunks == 0 && stats.chunk_frees == stats.chunk_allocations);
+		EXPECT_TRUE(stats.chunk_allocations >= 14);
+	}
+
+	template <class List>
+	concept has_probe = requires(const List& list) { list.probe(); };
+
+	TEST(Capacity, Probe)
+	{
+		static_assert(!has_probe<ChunkList<int, 8>>);
+
+		constexpr chunk_policy profiled{ .elements = 8, .probe = probe_level::latency };
+		ChunkList<int, profiled> list;
+		static_assert(has_probe<decltype(list)>);
+		for (int i = 0; i < 100; i++) list.push_back(i);
+		list.push_front(-1);
+		EXPECT_EQ(list.probe().back_chunks, 13u);
+		EXPECT_EQ(list.probe().front_chunks, 1u);
+
+		list.reset_probe();
+		long long sum = 0;
+		for (int i = 0; i < 10; i++) sum += list.at(i * 10);
+		EXPECT_EQ(sum, 440);
+		EXPECT_EQ(list.probe().lookups, 10u);
+		EXPECT_EQ(list.probe().element_moves, 0u);
+
+		list.insert(list.cbegin() + 50, 3, 7);
+		list.erase(list.cbegin() + 20);
+		list.erase(list.cbegin() + 30, list.cbegin() + 40);
+		const chunk_probe& probe = list.probe();
+		EXPECT_EQ(probe.inserts.count, 1u);
+		EXPECT_EQ(probe.erases.count, 2u);
+		EXPECT_TRUE(probe.element_moves > 0);
+		EXPECT_TRUE(probe.searches > 0);
+		EXPECT_EQ(std::accumulate(probe.erases.latency.begin(), probe.erases.latency.end(), std::uint64_t(0)), 2u);
+		EXPECT_TRUE(probe.inserts.nanoseconds > 0);
+
+		constexpr chunk_policy counted{ .elements = 8, .probe = probe_level::counters };
+		ChunkList<int, counted> counters(100000, 1);
+		counters.erase(counters.cbegin() + 5);
+		EXPECT_EQ(counters.probe().erases.count, 1u);
+		EXPECT_EQ(counters.probe().erases.nanoseconds, 0u);
+
+		ThreadPool pool(4);
+		counters.reset_probe();
+		transform(parallel_policy{ &pool }, counters, counters, [](int x) { return x + 1; });
+		EXPECT_EQ(std::count(counters.begin(), counters.end(), 2), 99999);
+		EXPECT_TRUE(counters.probe().lookups > 0);
+	}
+
+	TEST(Capacity, Compact)
+	{
+		PoolAllocator<std::string> alloc;
+		ChunkList<std::string, 8, PoolAllocator<std::string>> list(alloc);
+		std::vector<std::string> expected;
+		for (int i = 0; i < 800; i++) {
+			list.push_back(std::to_string(i));
+			expected.push_back(std::to_string(i));
+		}
+		for (int i = 790; i > 0; i -= 10) {
+			list.erase(list.cbegin() + i, list.cbegin() + i + 5);
+			expected.erase(expected.begin() + i, expected.begin() + i + 5);
+		}
+		list.insert(list.cbegin() + 3, 6, "x");
+		expected.insert(expected.begin() + 3, 6, "x");
+		list.pop_front();
+		expected.erase(expected.begin());
+		const long before = std::ranges::distance(list.chunks());
+
+		list.compact();
+		const long after = std::ranges::distance(list.chunks());
+		EXPECT_EQ(after, (static_cast<long>(list.size()) + 7) / 8);
+		EXPECT_TRUE(std::ranges::equal(list, expected));
+		for (auto chunk : list.chunks())
+			EXPECT_TRUE(chunk.size() == 8 || chunk.data() == &list.back() + 1 - chunk.size());
+
+		std::size_t capacity = alloc.resource()->capacity();
+		for (long i = 0; i < (before - after) * 8; i++) list.push_back("y");
+		EXPECT_TRUE(alloc.resource()->capacity() == capacity);
+
+		auto snapshot = list.snapshot();
+		list.erase(list.cbegin() + 100, list.cbegin() + 300);
+		list.shrink_to_fit();
+		EXPECT_TRUE(snapshot.size() == expected.size() + (before - after) * 8);
+		EXPECT_TRUE(std::equal(expected.begin(), expected.end(), snapshot.begin()));
+		EXPECT_TRUE(list[99] == expected[99]);
+		EXPECT_TRUE(list[100] == expected[300]);
+		EXPECT_EQ(std::ranges::distance(list.chunks()), (static_cast<long>(list.size()) + 7) / 8);
+
+		list.erase(list.cbegin(), list.cend());
+		list.compact();
+		EXPECT_TRUE(list.empty());
+		EXPECT_TRUE(std::ranges::distance(list.chunks()) == 0);
+	}
+
+	TEST(Capacity, IncrementalCompaction)
+	{
+		constexpr chunk_policy dense{ .elements = 16, .min_fill = 70 };
+		ChunkList<int, dense> list;
+		std::vector<int> expected;
+		for (int i = 0; i < 4000; i++) {
+			list.push_back(i);
+			expected.push_back(i);
+		}
+		unsigned seed = 1;
+		for (int step = 0; step < 3000; step++) {
+			seed = seed * 1664525u + 1013904223u;
+			int pos = static_cast<int>((seed >> 8) % list.size());
+			if (step % 3 == 0) {
+				list.insert(list.cbegin() + pos, step);
+				expected.insert(expected.begin() + pos, step);
+			}
+			else {
+				list.erase(list.cbegin() + pos);
+				expected.erase(expected.begin() + pos);
+			}
+			// A split and the partly filled tail may take the list two chunks
+			// past min_fill, the next steps catch up.
+			long chunks = std::ranges::distance(list.chunks());
+			EXPECT_TRUE(static_cast<long>(list.size()) * 100 >= 70 * (chunks - 2) * 16);
 		}
+		EXPECT_TRUE(std::ranges::equal(list, expected));
+	}
+
+	struct Point {
+		static inline int copies = 0;
+		int x, y;
+		std::string name;
+		Point(int x, int y, const char* name) : x(x), y(y), name(name) {}
+		Point(const Point& other) : x(other.x), y(other.y), name(other.name) { copies++; }
+		Point(Point&&) noexcept = default;
 	};
 
-	TEST_CLASS(Modifier) {
-		TEST_METHOD(Emplace)
-		{
-			ChunkList<int, 10> list = { 1,2,3,4,5 };
-			ChunkList<int, 10> expected = { 1,2,3,-1,-2,-3,-4,-5,4,5 };
+	TEST(Modifier, Emplace)
+	{
+		ChunkList<int, 10> list = { 1,2,3,4,5 };
+		ChunkList<int, 10> expected = { 1,2,3,-1,4,5 };
 
 
-			list.emplace(list.cbegin() + 3, -1, -2, -3, -4, -5);
+		auto it = list.emplace(list.cbegin() + 3, -1);
 
 
-			Assert::IsTrue(list == expected);
-		}
+		EXPECT_TRUE(list == expected);
+		EXPECT_EQ(-1, *it);
+	}
 
-		TEST_METHOD(EmplaceBack)
-		{
-			ChunkList<int, 10> list = { 1,2,3,4,5 };
-			ChunkList<int, 10> expected = { 1,2,3,4,5,-1,2 };
+	TEST(Modifier, EmplaceBack)
+	{
+		ChunkList<int, 10> list = { 1,2,3,4,5 };
+		ChunkList<int, 10> expected = { 1,2,3,4,5,-1 };
 
 
-			list.emplace_back(-1, 2);
-			
-			
-			Assert::IsTrue(list == expected);
-		}
+		int& back = list.emplace_back(-1);
+		
+		
+		EXPECT_TRUE(list == expected);
+		EXPECT_TRUE(&back == &list.back());
+	}
 
-		TEST_METHOD(EmplaceFront)
-		{
-			ChunkList<int, 10> list = { 1,2,3,4,5 };
-			ChunkList<int, 10> expected = { -1,2,-3,1,2,3,4,5 };
+	TEST(Modifier, EmplaceFront)
+	{
+		ChunkList<int, 10> list = { 1,2,3,4,5 };
+		ChunkList<int, 10> expected = { -1,1,2,3,4,5 };
 
-			auto it2 = list.emplace_front(-1,2,-3);
+		int& front = list.emplace_front(-1);
 
 
-			Assert::IsTrue(list == expected);
-		}
+		EXPECT_TRUE(list == expected);
+		EXPECT_TRUE(&front == &list.front());
+	}
+
+	TEST(Modifier, EmplaceConstructsInPlace)
+	{
+		ChunkList<Point, 4> list;
+		for (int i = 0; i < 9; i++) list.emplace_back(i, -i, "p");
+		list.emplace(list.cbegin() + 5, 100, 200, "middle");
+		list.emplace_front(-1, 1, "front");
 
-		TEST_METHOD(Insert1) {
-			ChunkList<int, 10> list;
-			ChunkList<int, 10> expected = { 100, 0, 1, 2 };
+		EXPECT_EQ(0, Point::copies);
+		EXPECT_TRUE(list.size() == 11);
+		EXPECT_EQ(-1, list.front().x);
+		EXPECT_TRUE(list[6].name == "middle");
+		EXPECT_EQ(-8, list.back().y);
 
-			for (int i = 0; i < 10; i++)
-				list.push_back(i);
+		ChunkList<std::unique_ptr<int>, 3> owners;
+		for (int i = 0; i < 5; i++) owners.emplace_back(new int(i));
+		owners.emplace(owners.cbegin() + 2, new int(42));
+		EXPECT_EQ(42, *owners[2]);
+		EXPECT_EQ(4, *owners.back());
+	}
 
-			list.clear();
+	TEST(Modifier, Insert1) {
+		ChunkList<int, 10> list;
+		ChunkList<int, 10> expected = { 100, 0, 1, 2 };
 
-			Assert::IsTrue(list.empty() == true);
-			Assert::IsTrue(list.size() == 0);
-			Assert::IsTrue(list.max_size() == 0);
+		for (int i = 0; i < 10; i++)
+			list.push_back(i);
 
-			for (int i = 0; i < 3; i++)
-				list.push_back(i);
+		list.clear();
 
-			auto it = list.cbegin();
-			list.insert(it, 100);
+		EXPECT_TRUE(list.empty() == true);
+		EXPECT_TRUE(list.size() == 0);
+		EXPECT_TRUE(list.capacity() == 0);
 
-			Assert::IsTrue(list == expected);
-		}
+		for (int i = 0; i < 3; i++)
+			list.push_back(i);
 
-		TEST_METHOD(Insert2) {
-			std::vector<int> vec = { -1,22,-333 };
-			ChunkList<int, 10> list = { 1,2,3,4,5 };
-			ChunkList<int, 10> expected = { -1,22,-333,1,2,3,4,5 };
+		auto it = list.cbegin();
+		list.insert(it, 100);
 
-			list.insert(list.cbegin(), vec.begin(), vec.end());
+		EXPECT_TRUE(list == expected);
+	}
 
-			Assert::IsTrue(list == expected);
-		}
+	TEST(Modifier, Insert2) {
+		std::vector<int> vec = { -1,22,-333 };
+		ChunkList<int, 10> list = { 1,2,3,4,5 };
+		ChunkList<int, 10> expected = { -1,22,-333,1,2,3,4,5 };
 
-		TEST_METHOD(Resize)
-		{
-			ChunkList<int, 8> list1 = { 1,2,3,4,5 };
-			ChunkList<int, 8> list2 = { 1,2,3,4,5,-1,-1,-1,-1,-1};
+		list.insert(list.cbegin(), vec.begin(), vec.end());
 
-			list1.resize(10, -1);
+		EXPECT_TRUE(list == expected);
+	}
 
-			Assert::IsTrue(list1 == list2);
+	TEST(Modifier, Resize)
+	{
+		ChunkList<int, 8> list1 = { 1,2,3,4,5 };
+		ChunkList<int, 8> list2 = { 1,2,3,4,5,-1,-1,-1,-1,-1};
 
-			list1.resize(4);
-			list2.resize(4);
+		list1.resize(10, -1);
 
-			Assert::IsTrue(list1 == list2);
-		}
+		EXPECT_TRUE(list1 == list2);
 
-		TEST_METHOD(Erase) {
-			ChunkList<int, 8> list = {1,2,3,4,5};
-			ChunkList<int, 8> expected = { 1,2,5 };
+		list1.resize(4);
+		list2.resize(4);
 
+		EXPECT_TRUE(list1 == list2);
+	}
 
-			list.erase(list.cbegin() + 1, list.cbegin() + 3);
+	TEST(Modifier, Erase) {
+		ChunkList<int, 8> list = {1,2,3,4,5};
+		ChunkList<int, 8> expected = { 1,4,5 };
 
 
-			Assert::IsTrue(list == expected);
-		}
+		list.erase(list.cbegin() + 1, list.cbegin() + 3);
+
 
-		TEST_METHOD(PushBack) {
-			ChunkList<int, 10> list;
+		EXPECT_TRUE(list == expected);
+	}
 
-			for (int i = 0; i < 11; i++)
-				list.push_back(i);
+	TEST(Modifier, InsertEraseBlocks) {
+		ChunkList<int, 5> list;
+		std::vector<int> expected;
+		unsigned seed = 7;
+		auto random = [&seed](int bound) {
+			seed = seed * 1664525u + 1013904223u;
+			return bound > 0 ? static_cast<int>((seed >> 8) % bound) : 0;
+		};
 
-			Assert::IsTrue(list[0] == 0);
-			Assert::IsTrue(list[10] == 10);
+		for (int step = 0; step < 400; step++) {
+			int pos = random(static_cast<int>(expected.size()) + 1);
+			if (random(3) != 0 || expected.empty()) {
+				std::vector<int> values(random(12) + 1, step);
+				list.insert(list.cbegin() + pos, values.begin(), values.end());
+				expected.insert(expected.begin() + pos, values.begin(), values.end());
+			}
+			else {
+				int count = std::min(random(14) + 1, static_cast<int>(expected.size()) - pos);
+				list.erase(list.cbegin() + pos, list.cbegin() + pos + count);
+				expected.erase(expected.begin() + pos, expected.begin() + pos + count);
+			}
+
+			EXPECT_TRUE(list.size() == expected.size());
+			for (size_t i = 0; i < expected.size(); i++) EXPECT_EQ(expected[i], list[i]);
 		}
 
-		TEST_METHOD(PushFront) {
-			ChunkList<int, 10> list;
+		int i = 0;
+		for (int x : list) EXPECT_EQ(expected[i++], x);
+	}
 
-			for (int i = 0; i < 11; i++)
-				list.push_back(i);
+	TEST(Modifier, InsertElementOfTheList) {
+		ChunkList<int, 8> list{ 1, 2, 3 };
+		list.insert(list.cbegin(), list.back());
+		EXPECT_TRUE((list == ChunkList<int, 8>({ 3, 1, 2, 3 })));
+		list.insert(list.cbegin() + 1, 2, list[2]);
+		EXPECT_TRUE((list == ChunkList<int, 8>({ 3, 2, 2, 1, 2, 3 })));
 
-			list.push_front(42);
-			Assert::IsTrue(list[0] == 42);
-		}
+		// Splits the chunk, so the element is parked in a spare chunk first.
+		ChunkList<std::string, 4> words{ "a", "b", "c", "d" };
+		words.insert(words.cbegin() + 1, words[3]);
+		words.insert(words.cbegin(), 3, words[1]);
+		EXPECT_TRUE((words == ChunkList<std::string, 4>({ "d", "d", "d", "a", "d", "b", "c", "d" })));
+
+		ChunkList<int, 8> emplaced{ 1, 2, 3 };
+		emplaced.emplace(emplaced.cbegin(), emplaced.back());
+		EXPECT_TRUE((emplaced == ChunkList<int, 8>({ 3, 1, 2, 3 })));
+		words.emplace(words.cbegin() + 4, words[3], 0, 1);
+		EXPECT_EQ(words[4], "a");
+		EXPECT_EQ(words[5], "d");
+	}
+
+	TEST(Modifier, PushBack) {
+		ChunkList<int, 10> list;
+
+		for (int i = 0; i < 11; i++)
+			list.push_back(i);
+
+		EXPECT_TRUE(list[0] == 0);
+		EXPECT_TRUE(list[10] == 10);
+	}
+
+	TEST(Modifier, PushFront) {
+		ChunkList<int, 10> list;
+
+		for (int i = 0; i < 11; i++)
+			list.push_back(i);
+
+		list.push_front(42);
+		EXPECT_TRUE(list[0] == 42);
+	}
+
+	TEST(Modifier, PopBack) {
+		ChunkList<int, 10> list;
 
-		TEST_METHOD(PopBack) {
-			ChunkList<int, 10> list;
+		for (int i = 0; i < 11; i++)
+			list.push_back(i);
 
-			for (int i = 0; i < 11; i++)
-				list.push_back(i);
+		list.pop_back();
+		EXPECT_TRUE(list.size() == 10);
+	}
 
+	TEST(Modifier, PushPopBackAcrossChunks) {
+		ChunkList<int, 4> list;
+
+		for (int i = 0; i < 100; i++) {
+			list.push_back(i);
+			EXPECT_TRUE(list.back() == i);
+		}
+
+		for (int i = 99; i >= 2; i--) {
+			EXPECT_TRUE(list.back() == i);
 			list.pop_back();
-			Assert::IsTrue(list.size() == 10);
 		}
 
-		TEST_METHOD(PopFront) {
-			ChunkList<int, 10> list;
+		list.push_back(42);
+		EXPECT_TRUE(list.size() == 3);
+		EXPECT_TRUE(list.capacity() == 4);
+		EXPECT_TRUE(list[1] == 1);
+		EXPECT_TRUE(list.back() == 42);
+	}
+
+	TEST(Modifier, PopFront) {
+		ChunkList<int, 10> list;
+
+		for (int i = 0; i < 11; i++)
+			list.push_back(i);
 
-			for (int i = 0; i < 11; i++)
-				list.push_back(i);
+		list.pop_front();
+		EXPECT_TRUE(list[0] == 1);
+	}
+
+	TEST(Modifier, PushPopFrontAcrossChunks) {
+		ChunkList<std::string, 4> list;
+		std::deque<std::string> expected;
+
+		for (int i = 0; i < 100; i++) {
+			list.push_front(std::to_string(i));
+			expected.push_front(std::to_string(i));
+			EXPECT_TRUE(list.front() == expected.front());
+		}
+		EXPECT_TRUE(std::equal(list.begin(), list.end(), expected.begin(), expected.end()));
+		EXPECT_TRUE(std::equal(list.rbegin(), list.rend(), expected.rbegin(), expected.rend()));
+
+		// Mixed deque use, with snapshots taken along the way that must not change.
+		unsigned seed = 7;
+		std::vector<std::pair<ChunkList<std::string, 4>::snapshot_type, std::deque<std::string>>> views;
+		for (int step = 0; step < 2000; step++) {
+			seed = seed * 1664525u + 1013904223u;
+			std::string value = std::to_string(step);
+			int pos = expected.empty() ? 0 : static_cast<int>((seed >> 8) % expected.size());
+			switch ((seed >> 24) % 7) {
+			case 0: list.push_front(value); expected.push_front(value); break;
+			case 1: list.push_back(value); expected.push_back(value); break;
+			case 2: if (!expected.empty()) { list.pop_front(); expected.pop_front(); } break;
+			case 3: if (!expected.empty()) { list.pop_back(); expected.pop_back(); } break;
+			case 4: list.insert(list.cbegin() + pos, value); expected.insert(expected.begin() + pos, value); break;
+			case 5: if (!expected.empty()) { list.erase(list.cbegin() + pos); expected.erase(expected.begin() + pos); } break;
+			case 6: if (step % 100 == 6) views.emplace_back(list.snapshot(), expected); break;
+			}
+			ASSERT_EQ(list.size(), expected.size());
+			if (!expected.empty()) {
+				std::size_t at = seed % expected.size();
+				EXPECT_TRUE(list.at(at) == expected[at]);
+			}
+		}
+		EXPECT_TRUE(std::equal(list.begin(), list.end(), expected.begin(), expected.end()));
+		for (auto& [view, contents] : views) {
+			EXPECT_TRUE(std::equal(view.begin(), view.end(), contents.begin(), contents.end()));
+			if (!contents.empty()) {
+				EXPECT_TRUE(view[contents.size() / 2] == contents[contents.size() / 2]);
+			}
+		}
 
+		auto chunks = list.chunks();
+		for (std::size_t i = 0; i < chunks.size(); i++)
+			EXPECT_TRUE(list[chunks.position(i)] == chunks[i][0]);
+		EXPECT_TRUE(chunks.position(chunks.size() - 1) + chunks.back().size() == list.size());
+		while (!expected.empty()) {
+			EXPECT_TRUE(list.front() == expected.front());
 			list.pop_front();
-			Assert::IsTrue(list[0] == 1);
+			expected.pop_front();
+		}
+		EXPECT_TRUE(list.empty());
+	}
+
+	TEST(Modifier, LocalEditsInPartialChunks) {
+		ChunkList<char, 8> text;
+		std::vector<char> expected;
+		for (int i = 0; i < 4000; i++) {
+			text.push_back(static_cast<char>('a' + i % 26));
+			expected.push_back(static_cast<char>('a' + i % 26));
+		}
+
+		// Editor-like use: a cursor that mostly moves a little between edits and
+		// sometimes jumps, with pushes at both ends in between.
+		unsigned seed = 3;
+		int cursor = 2000;
+		for (int step = 0; step < 5000; step++) {
+			seed = seed * 1664525u + 1013904223u;
+			int size = static_cast<int>(expected.size());
+			cursor = (seed >> 28) == 0 ? static_cast<int>((seed >> 8) % (size + 1)) : std::clamp(cursor + static_cast<int>((seed >> 8) % 41) - 20, 0, size);
+			char value = static_cast<char>('A' + step % 26);
+			switch ((seed >> 24) % 8) {
+			case 0: case 1: case 2:
+				text.insert(text.cbegin() + cursor, value);
+				expected.insert(expected.begin() + cursor, value);
+				break;
+			case 3: case 4: case 5:
+				if (cursor < size) {
+					text.erase(text.cbegin() + cursor);
+					expected.erase(expected.begin() + cursor);
+				}
+				break;
+			case 6: text.push_front(value); expected.insert(expected.begin(), value); break;
+			case 7: text.push_back(value); expected.push_back(value); break;
+			}
+			ASSERT_EQ(text.size(), expected.size());
+			std::size_t at = seed % expected.size();
+			EXPECT_EQ(text.at(at), expected[at]);
+		}
+		EXPECT_TRUE(std::ranges::equal(text, expected));
+		EXPECT_TRUE(std::equal(text.rbegin(), text.rend(), expected.rbegin(), expected.rend()));
+
+		std::size_t position = 0;
+		auto chunks = std::as_const(text).chunks();
+		for (std::size_t i = 0; i < chunks.size(); i++) {
+			EXPECT_EQ(chunks.position(i), position);
+			position += chunks[i].size();
 		}
+
+		auto view = text.snapshot();
+		ChunkList<char, 8> other = { 'x', 'y' };
+		swap(text, other);
+		other.insert(other.cbegin() + 100, 'z');
+		EXPECT_TRUE(std::ranges::equal(view, expected));
+		expected.insert(expected.begin() + 100, 'z');
+		EXPECT_TRUE(std::ranges::equal(other, expected));
+		EXPECT_TRUE(text.size() == 2 && text[1] == 'y');
+	}
+
+	struct Tracked {
+		static inline int alive = 0;
+		std::string value;
+		Tracked(const std::string& value) : value(value) { alive++; }
+		Tracked(const Tracked& other) : value(other.value) { alive++; }
+		Tracked(Tracked&& other) noexcept : value(std::move(other.value)) { alive++; }
+		Tracked& operator=(const Tracked&) = default;
+		Tracked& operator=(Tracked&&) = default;
+		~Tracked() { alive--; }
 	};
 
-	TEST_CLASS(Comparision) {
-		TEST_METHOD(Comparisions) {
-			ChunkList<int, 10> list1 = { 1,2,3,4,5 };
-			ChunkList<int, 10> list2 = { 1,2,3,4,5 };
-			ChunkList<int, 10> list3 = { 1,2,6,4,5 };
-			ChunkList<int, 10> list4 = { 1,2,3,4,5,1 };
-
-
-			Assert::IsTrue(list1 == list2);
-			Assert::IsTrue(list1 <= list2);
-			Assert::IsTrue(list1 >= list2);
-			Assert::IsTrue(list3 > list2);
-			Assert::IsTrue(list4 > list2);
-			Assert::IsTrue(list1 < list4);
-			Assert::IsFalse(list2 > list3);
+	TEST(ElementLifetime, OnlyOccupiedSlotsAreConstructed)
+	{
+		{
+			ChunkList<Tracked, 4> list;
+			for (int i = 0; i < 10; i++) list.push_back(Tracked(std::to_string(i)));
+			EXPECT_EQ(10, Tracked::alive);
+
+			list.insert(list.cbegin() + 3, 5, Tracked("x"));
+			list.erase(list.cbegin() + 1, list.cbegin() + 7);
+			list.pop_back();
+			EXPECT_EQ(8, Tracked::alive);
+
+			ChunkList<Tracked, 4> copy = list;
+			EXPECT_EQ(16, Tracked::alive);
+			EXPECT_TRUE(copy[1].value == "x");
+			EXPECT_TRUE(copy.back().value == "8");
+		}
+		EXPECT_EQ(0, Tracked::alive);
+	}
+
+	TEST(ElementLifetime, Strings)
+	{
+		ChunkList<std::string, 3> list;
+		for (int i = 0; i < 20; i++) list.push_back(std::string(30, static_cast<char>('a' + i)));
+
+		list.erase(list.cbegin() + 2, list.cbegin() + 7);
+		list.insert(list.cbegin() + 4, std::string(40, 'z'));
+
+		EXPECT_TRUE(list.size() == 16);
+		EXPECT_TRUE(list[1] == std::string(30, 'b'));
+		EXPECT_TRUE(list[2] == std::string(30, 'h'));
+		EXPECT_TRUE(list[4] == std::string(40, 'z'));
+		EXPECT_TRUE(list.back() == std::string(30, 't'));
+	}
+
+	struct Fussy {
+		std::string text;
+		explicit Fussy(int value) : text(std::to_string(value)) {
+			if (value < 0) throw std::invalid_argument("fussy");
+		};
+	};
+
+	TEST(ElementLifetime, ThrowingElementLeavesNoEmptyChunk)
+	{
+		ChunkList<Fussy, 4> list;
+		for (int i = 0; i < 4; i++) list.emplace_back(i);
+		EXPECT_THROW(list.emplace_back(-1), std::invalid_argument);
+		EXPECT_THROW(list.emplace_front(-1), std::invalid_argument);
+		EXPECT_TRUE(list.size() == 4);
+		EXPECT_TRUE(list.stats().chunks == 1);
+		EXPECT_TRUE(std::ranges::none_of(std::as_const(list).chunks(), [](auto chunk) { return chunk.empty(); }));
+
+		list.emplace_back(4);
+		EXPECT_TRUE(list.back().text == "4" && list.stats().chunks == 2);
+
+		// A range inserted at the end that throws on the first element of a
+		// new chunk keeps the elements before it.
+		ChunkList<Fussy, 4> range;
+		std::vector<int> values = { 0, 1, 2, 3, 4, 5, 6, 7, -1, 9 };
+		auto fussy = [](int value) { return Fussy(value); };
+		auto first = std::views::transform(values, fussy);
+		EXPECT_THROW(range.insert(range.cend(), first.begin(), first.end()), std::invalid_argument);
+		EXPECT_TRUE(range.size() == 8);
+		EXPECT_TRUE(range.stats().chunks == 2);
+		EXPECT_TRUE(std::ranges::none_of(std::as_const(range).chunks(), [](auto chunk) { return chunk.empty(); }));
+		EXPECT_TRUE(range.back().text == "7");
+	}
+
+	/// Counts its live instances; copying throws once copies_left runs out.
+	struct Brittle {
+		inline static int live = 0;
+		inline static int copies_left = -1;
+		int value;
+		explicit Brittle(int value) : value(value) { live++; };
+		Brittle(const Brittle& other) : value(other.value) {
+			if (copies_left-- == 0) throw std::runtime_error("brittle");
+			live++;
+		};
+		~Brittle() { live--; };
+	};
+
+	TEST(ElementLifetime, ThrowingConstructorLeavesNothing)
+	{
+		{
+			using Brittles = ChunkList<Brittle, 4>;
+			std::vector<Brittle> values(10, Brittle(1));
+			Brittles list(values.begin(), values.end());
+			Brittle::copies_left = 6;
+			EXPECT_THROW(Brittles copy(values.begin(), values.end()), std::runtime_error);
+			EXPECT_EQ(Brittle::live, 20);
+			Brittle::copies_left = 6;
+			EXPECT_THROW(Brittles copy(list), std::runtime_error);
+			EXPECT_EQ(Brittle::live, 20);
+			Brittle::copies_left = 6;
+			EXPECT_THROW(Brittles copy(10, values[0]), std::runtime_error);
+			EXPECT_EQ(Brittle::live, 20);
+			Brittle::copies_left = -1;
+		}
+		EXPECT_EQ(Brittle::live, 0);
+	}
+
+	TEST(ElementLifetime, ThrowingInsertInsideChunkRollsBack)
+	{
+		auto fussy = [](int value) { return Fussy(value); };
+		auto texts = [](const auto& list) {
+			std::string joined;
+			for (const Fussy& value : list) joined += value.text + " ";
+			return joined;
+		};
+
+		// Fits into the chunk: the gap opened for the new elements is closed.
+		ChunkList<Fussy, 8> gap;
+		for (int i = 0; i < 4; i++) gap.emplace_back(i);
+		std::vector<int> two = { 10, -1 };
+		auto values = std::views::transform(two, fussy);
+		EXPECT_THROW(gap.insert(gap.cbegin() + 1, values.begin(), values.end()), std::invalid_argument);
+		EXPECT_EQ(texts(gap), "0 1 2 3 ");
+
+		// Splits the chunk: the new chunks are dropped and the elements parked
+		// in the spare chunk go back.
+		ChunkList<Fussy, 4> split;
+		for (int i = 0; i < 4; i++) split.emplace_back(i);
+		std::vector<int> four = { 10, 11, 12, -1 };
+		values = std::views::transform(four, fussy);
+		EXPECT_THROW(split.insert(split.cbegin() + 2, values.begin(), values.end()), std::invalid_argument);
+		EXPECT_TRUE(split.size() == 4);
+		EXPECT_EQ(texts(split), "0 1 2 3 ");
+		auto stats = split.stats();
+		EXPECT_TRUE(stats.chunks == 1 && stats.chunk_allocations - stats.chunk_frees == 1);
+
+		// Throws after elements behind the cut were moved to a new chunk.
+		ChunkList<Fussy, 8> moved;
+		for (int i = 0; i < 8; i++) moved.emplace_back(i);
+		std::vector<int> one = { -1 };
+		auto value = std::views::transform(one, fussy);
+		EXPECT_THROW(moved.insert(moved.cbegin() + 7, value.begin(), value.end()), std::invalid_argument);
+		EXPECT_EQ(texts(moved), "0 1 2 3 4 5 6 7 ");
+		stats = moved.stats();
+		EXPECT_TRUE(stats.chunks == 1 && stats.chunk_allocations - stats.chunk_frees == 1);
+		moved.insert(moved.cbegin() + 7, Fussy(9));
+		EXPECT_EQ(texts(moved), "0 1 2 3 4 5 6 9 7 ");
+	}
+
+	TEST(Allocation, PoolReusesFreedChunks)
+	{
+		PoolAllocator<int> alloc;
+		ChunkList<int, 16, PoolAllocator<int>> list(alloc);
+		for (int i = 0; i < 1000; i++) list.push_back(i);
+		std::size_t capacity = alloc.resource()->capacity();
+
+		for (int round = 0; round < 50; round++) {
+			list.clear();
+			for (int i = 0; i < 1000; i++) list.push_back(i);
+			list.erase(list.cbegin() + 100, list.cbegin() + 600);
+			list.insert(list.cbegin() + 100, 500, 7);
 		}
+		EXPECT_TRUE(alloc.resource()->capacity() == capacity);
+		EXPECT_TRUE(list.size() == 1000);
+		EXPECT_EQ(99, list[99]);
+		EXPECT_EQ(7, list[100]);
+		EXPECT_EQ(999, list.back());
+
+		ChunkList<int, 16, PoolAllocator<int>> copy = list;
+		EXPECT_TRUE(copy.get_allocator() == alloc);
+		EXPECT_EQ(7, copy[599]);
+	}
+
+	TEST(Allocation, ChunkLayout)
+	{
+		static_assert(ChunkList<int, auto_chunk_size<int>>::chunk_bytes == 16384);
+		static_assert(ChunkList<int, auto_chunk_size<int, 4096>>::chunk_bytes == 4096);
+		static_assert(ChunkList<double, auto_chunk_size<double, 256>>::chunk_bytes == 256);
+		static_assert(ChunkList<char, 10>::chunk_bytes % chunk_alignment == 0);
+
+		ChunkList<double, auto_chunk_size<double, 256>> list(100, 1.5);
+		ChunkList<double, auto_chunk_size<double, 256>, PoolAllocator<double>> pooled(100, 1.5);
+		for (int i = 0; i < 100; i += 29) {
+			EXPECT_TRUE(reinterpret_cast<std::uintptr_t>(&list[i]) % alignof(double) == 0);
+			EXPECT_TRUE(reinterpret_cast<std::uintptr_t>(&pooled[i]) % alignof(double) == 0);
+		}
+		const std::size_t header = (2 * sizeof(void*) + 3 * sizeof(int) + alignof(double) - 1) / alignof(double) * alignof(double);
+		EXPECT_TRUE(reinterpret_cast<std::uintptr_t>(&list[0]) % chunk_alignment == header);
+		EXPECT_TRUE(reinterpret_cast<std::uintptr_t>(&pooled[0]) % chunk_alignment == header);
+	}
+
+	TEST(Allocation, ChunkPolicy)
+	{
+		static_assert(ChunkList<int, auto_chunk<4096>>::chunk_bytes == 4096);
+		static_assert(ChunkList<int, auto_chunk<4096>>::chunk_size == auto_chunk_size<int, 4096>);
+		static_assert(ChunkList<std::string, auto_chunk<>>::chunk_bytes == 16384);
+		struct Record { char bytes[1000]; };
+		static_assert(ChunkList<Record, auto_chunk<1024>>::chunk_size == 1);
+		static_assert(ChunkList<int, 10>::chunk_size == 10);
+
+		constexpr chunk_policy paged{ .block_bytes = 8192, .alignment = 4096 };
+		static_assert(ChunkList<double, paged>::chunk_bytes == 8192);
+		ChunkList<double, paged> list;
+		for (int i = 0; i < 5000; i++) list.push_back(i);
+		EXPECT_TRUE(reinterpret_cast<std::uintptr_t>(list.last_chunk()) % 4096 == 0);
+
+		constexpr chunk_policy tiny{ .elements = 3, .growth = 3 };
+		ChunkList<std::string, tiny> strings;
+		for (int i = 0; i < 100; i++) strings.push_back(std::to_string(i));
+		strings.insert(strings.cbegin() + 50, 20, "x");
+		strings.erase(strings.cbegin() + 10, strings.cbegin() + 40);
+		EXPECT_TRUE(strings.size() == 90);
+		EXPECT_TRUE(strings[20] == "x");
+		EXPECT_TRUE(strings[40] == "50");
+		EXPECT_TRUE(strings.back() == "99");
+		EXPECT_TRUE(std::ranges::all_of(strings.chunks(), [](auto chunk) { return chunk.size() <= 3; }));
+	}
+
+	TEST(Allocation, MonotonicArena)
+	{
+		PoolAllocator<std::string> arena(true);
+		{
+			ChunkList<std::string, 8, PoolAllocator<std::string>> list(arena);
+			for (int i = 0; i < 100; i++) list.push_back(std::to_string(i));
+			list.erase(list.cbegin(), list.cbegin() + 50);
+			EXPECT_TRUE(list.front() == "50");
+			EXPECT_TRUE(list.back() == "99");
+		}
+		EXPECT_TRUE(arena.resource()->is_monotonic());
+		EXPECT_TRUE(arena.resource()->capacity() > 0);
+	}
+
+	TEST(Comparision, Comparisions) {
+		ChunkList<int, 10> list1 = { 1,2,3,4,5 };
+		ChunkList<int, 10> list2 = { 1,2,3,4,5 };
+		ChunkList<int, 10> list3 = { 1,2,6,4,5 };
+		ChunkList<int, 10> list4 = { 1,2,3,4,5,1 };
+
+
+		EXPECT_TRUE(list1 == list2);
+		EXPECT_TRUE(list1 <= list2);
+		EXPECT_TRUE(list1 >= list2);
+		EXPECT_TRUE(list3 > list2);
+		EXPECT_TRUE(list4 > list2);
+		EXPECT_TRUE(list1 < list4);
+		EXPECT_FALSE(list2 > list3);
+	}
+
+	/// Equal by the last decimal digit only, so equal values differ in bytes.
+	struct Mod10 {
+		int value;
+		friend bool operator==(const Mod10& a, const Mod10& b) { return a.value % 10 == b.value % 10; };
 	};
+
+	TEST(Comparision, LexicographicAcrossChunks) {
+		ChunkList<int, 4> shorter = { 2 };
+		ChunkList<int, 4> longer = { 1, 5, 6 };
+		EXPECT_TRUE(shorter > longer);
+		EXPECT_TRUE((shorter <=> longer) == std::strong_ordering::greater);
+
+		ChunkList<int, 4> a;
+		ChunkList<int, 4> b;
+		for (int i = 0; i < 100; i++) {
+			a.push_back(i);
+			b.push_back(i);
+		}
+		a.erase(a.cbegin() + 10, a.cbegin() + 20);
+		a.insert(a.cbegin() + 10, { 10, 11, 12, 13, 14, 15, 16, 17, 18, 19 });
+		EXPECT_TRUE(a == b);
+		EXPECT_TRUE((a <=> b) == 0);
+
+		b[57] = -1;
+		EXPECT_TRUE(a != b);
+		EXPECT_TRUE(a > b);
+		b.pop_back();
+		b[57] = 57;
+		EXPECT_TRUE(b < a);
+
+		ChunkList<double, 3> x = { 1.0, 0.0 };
+		ChunkList<double, 3> y = { 1.0, -0.0 };
+		EXPECT_TRUE(x == y);
+
+		ChunkList<std::string, 2> s1 = { "ab", "cd", "ef" };
+		ChunkList<std::string, 2> s2 = { "ab", "ce" };
+		EXPECT_TRUE(s1 < s2);
+
+		ChunkList<Mod10, 4> m1 = { { 1 }, { 2 } };
+		ChunkList<Mod10, 4> m2 = { { 11 }, { 12 } };
+		EXPECT_TRUE(m1 == m2);
+	}
+
+	TEST(Algorithms, ChunkSpans)
+	{
+		static_assert(std::ranges::random_access_range<ChunkList<int, 4>::chunk_range>);
+		static_assert(std::ranges::sized_range<ChunkList<int, 4>::const_chunk_range>);
+
+		ChunkList<int, 4> list;
+		for (int i = 0; i < 10; i++) list.push_back(i);
+		list.erase(list.cbegin() + 5);
+
+		std::vector<int> seen;
+		std::size_t chunks = 0;
+		for (std::span<const int> span : std::as_const(list).chunks()) {
+			EXPECT_FALSE(span.empty());
+			seen.insert(seen.end(), span.begin(), span.end());
+			chunks++;
+		}
+		EXPECT_TRUE(chunks == list.chunks().size());
+		EXPECT_TRUE(list.chunks().position(2) == list.chunks()[0].size() + list.chunks()[1].size());
+		EXPECT_EQ(list[list.chunks().position(2)], list.chunks()[2][0]);
+		EXPECT_TRUE(seen == std::vector<int>({ 0, 1, 2, 3, 4, 6, 7, 8, 9 }));
+
+		for (std::span<int> span : list.chunks())
+			for (int& x : span) x *= 2;
+		EXPECT_EQ(18, list.back());
+		EXPECT_TRUE((ChunkList<int, 4>().chunks().empty()));
+	}
+
+	TEST(Algorithms, SegmentedAlgorithms)
+	{
+		ChunkList<int, 4> list;
+		for (int i = 0; i < 100; i++) list.push_back(i % 10);
+		list.erase(list.cbegin() + 13, list.cbegin() + 15);
+
+		EXPECT_EQ(443, accumulate(list, 0));
+		EXPECT_EQ(0, accumulate(list, 1, std::multiplies<>()));
+		EXPECT_TRUE(count(list, 3) == 9);
+		EXPECT_TRUE(count(list, 42) == 0);
+
+		auto it = find(list, 5);
+		EXPECT_TRUE(it - list.begin() == 5);
+		it = find(list, 3);
+		EXPECT_TRUE(it - list.begin() == 3);
+		EXPECT_TRUE(find(std::as_const(list), 42) == list.cend());
+		*find(list, 4) = -4;
+		EXPECT_EQ(-4, list[4]);
+
+		int sum = 0;
+		for_each(list, [&sum](int x) { sum += x; });
+		EXPECT_EQ(435, sum);
+
+		std::vector<int> out(list.size());
+		EXPECT_TRUE(copy(list, out.begin()) == out.end());
+		EXPECT_TRUE(std::equal(out.begin(), out.end(), list.begin()));
+
+		fill(list, 7);
+		EXPECT_TRUE(count(list, 7) == list.size());
+
+		ChunkList<std::string, 3> words = { "a", "b", "c", "d" };
+		EXPECT_TRUE(accumulate(words, std::string()) == "abcd");
+		EXPECT_TRUE(find(words, "c") == words.begin() + 2);
+	}
+
+	TEST(Algorithms, ParallelAlgorithms)
+	{
+		ThreadPool pool(4);
+		parallel_policy policy{ &pool };
+
+		ChunkList<int, 16> list;
+		for (int i = 0; i < 10000; i++) list.push_back((i * 7919) % 10007);
+		list.erase(list.cbegin() + 100, list.cbegin() + 150);
+		list.insert(list.cbegin() + 5000, 30, -1);
+		std::vector<int> expected(list.begin(), list.end());
+
+		for_each(policy, list, [](int& x) { x += 1; });
+		for (int& x : expected) x += 1;
+		EXPECT_TRUE(std::equal(expected.begin(), expected.end(), list.begin()));
+
+		ChunkList<long long, 64> squares;
+		transform(policy, list, squares, [](int x) { return static_cast<long long>(x) * x; });
+		EXPECT_TRUE(squares.size() == list.size());
+		EXPECT_TRUE(squares[5010] == 0);
+		EXPECT_TRUE(squares[777] == static_cast<long long>(list[777]) * list[777]);
+
+		// Writing into lists whose chunks live snapshots still share.
+		auto before = squares.snapshot();
+		std::vector<long long> old_squares(before.begin(), before.end());
+		transform(policy, list, squares, [](int x) { return static_cast<long long>(x) + 1; });
+		EXPECT_TRUE(std::equal(before.begin(), before.end(), old_squares.begin(), old_squares.end()));
+		EXPECT_TRUE(squares[777] == list[777] + 1LL);
+		auto shared = list.snapshot();
+		transform(policy, list, list, [](int x) { return x - 1; });
+		EXPECT_TRUE(std::equal(expected.begin(), expected.end(), shared.begin(), shared.end()));
+		EXPECT_TRUE(list[777] == expected[777] - 1);
+		for_each(policy, list, [](int& x) { x += 1; });
+		EXPECT_TRUE(std::equal(expected.begin(), expected.end(), list.begin()));
+
+		long long total = std::accumulate(expected.begin(), expected.end(), 0LL);
+		EXPECT_TRUE(reduce(policy, list, 0LL) == total);
+		EXPECT_TRUE(reduce(par, list, 0LL) == total);
+		EXPECT_TRUE(count_if(policy, list, [](int x) { return x % 2 == 0; })
+			== static_cast<std::size_t>(std::count_if(expected.begin(), expected.end(), [](int x) { return x % 2 == 0; })));
+
+		auto unsorted = list.snapshot();
+		sort(policy, list);
+		EXPECT_TRUE(std::equal(expected.begin(), expected.end(), unsorted.begin(), unsorted.end()));
+		std::sort(expected.begin(), expected.end());
+		EXPECT_TRUE(std::equal(expected.begin(), expected.end(), list.begin()));
+		sort(policy, list, std::greater<>());
+		EXPECT_TRUE(std::equal(expected.rbegin(), expected.rend(), list.begin()));
+
+		EXPECT_THROW(for_each(policy, list, [](int& x) { if (x == 5000) throw std::runtime_error("stop"); }), std::runtime_error);
+		ChunkList<int, 16> empty;
+		sort(policy, empty);
+		EXPECT_TRUE(reduce(policy, empty, 3) == 3);
+	}
+
+	TEST(Algorithms, ArithmeticKernels)
+	{
+		ChunkList<int, 37> ints;
+		ChunkList<int, 37> weights;
+		ChunkList<double, 5> doubles;
+		ChunkList<float, 64> floats;
+		long long int_sum = 0;
+		long long int_dot = 0;
+		for (int i = 0; i < 1000; i++) {
+			int value = (i % 2 ? -1 : 1) * (2000000000 - i * 7);
+			ints.push_back(value);
+			weights.push_back(i % 5 - 2);
+			doubles.push_back(i * 0.5);
+			floats.push_back(static_cast<float>(i % 8));
+			int_sum += value;
+			int_dot += static_cast<long long>(value) * (i % 5 - 2);
+		}
+		ints.erase(ints.cbegin() + 100, ints.cbegin() + 103);
+		ints.insert(ints.cbegin() + 100, { 2000000000 - 7 * 100, -2000000000 + 7 * 101, 2000000000 - 7 * 102 });
+		ints.insert(ints.cbegin() + 100, -2000000000);
+		ints.erase(ints.cbegin() + 100);
+
+		EXPECT_TRUE(sum(ints) == int_sum);
+		EXPECT_TRUE(dot(ints, weights) == int_dot);
+		EXPECT_EQ(2000000000, max(ints));
+		EXPECT_EQ(-2000000000 + 7, min(ints));
+		EXPECT_TRUE(count(ints, 2000000000 - 7 * 998) == 1);
+		EXPECT_TRUE(find(ints, -(2000000000 - 7 * 999)) == ints.begin() + 999);
+
+		EXPECT_TRUE(sum(doubles) == 249750.0);
+		EXPECT_TRUE(dot(doubles, doubles) == 83208375.0);
+		EXPECT_TRUE(max(doubles) == 499.5);
+		EXPECT_TRUE(min(doubles) == 0.0);
+		EXPECT_TRUE(find(doubles, 250.0) == doubles.begin() + 500);
+
+		EXPECT_TRUE(sum(floats) == 3500.0f);
+		EXPECT_TRUE(count(floats, 7.0f) == 125);
+		EXPECT_TRUE(find(floats, 6.0f) == floats.begin() + 6);
+		EXPECT_TRUE(find(floats, 8.0f) == floats.end());
+
+		ChunkList<short, 3> shorts = { 3, -4, 5 };
+		EXPECT_TRUE(sum(shorts) == 4);
+		EXPECT_TRUE(dot(shorts, shorts) == 50);
+		EXPECT_THROW(min(ChunkList<int, 4>()), std::out_of_range);
+		EXPECT_THROW(dot(shorts, ChunkList<short, 3>(2)), std::invalid_argument);
+	}
+
+	TEST(Concurrency, ConcurrentAppend)
+	{
+		static_assert(std::ranges::forward_range<ConcurrentChunkList<int, 16>>);
+		const int producers = 8;
+		const int per_producer = 20000;
+		ConcurrentChunkList<int, 16> list;
+		std::atomic<bool> done = false;
+
+		// A reader walks the list while it grows: every producer's values
+		// must show up in push order and the prefix seen must only grow.
+		std::thread reader([&] {
+			std::size_t seen = 0;
+			while (!done) {
+				std::vector<int> next(producers, 0);
+				std::size_t count = 0;
+				for (int value : list) {
+					int producer = value / per_producer;
+					EXPECT_TRUE(value % per_producer == next[producer]++);
+					count++;
+				}
+				EXPECT_TRUE(count >= seen);
+				seen = count;
+			}
+		});
+		std::vector<std::thread> threads;
+		for (int p = 0; p < producers; p++)
+			threads.emplace_back([&list, p] {
+				for (int i = 0; i < per_producer; i++)
+					list.push_back(p * per_producer + i);
+			});
+		for (std::thread& thread : threads) thread.join();
+		done = true;
+		reader.join();
+
+		EXPECT_TRUE(list.size() == static_cast<std::size_t>(producers * per_producer));
+		std::vector<int> values;
+		std::ranges::copy(list, std::back_inserter(values));
+		std::sort(values.begin(), values.end());
+		for (int i = 0; i < producers * per_producer; i++)
+			EXPECT_TRUE(values[i] == i);
+
+		struct Picky {
+			std::string text;
+			explicit Picky(int value) : text(std::to_string(value)) {
+				if (value % 5 == 0) throw std::invalid_argument("picky");
+			};
+		};
+		ConcurrentChunkList<Picky, 4> picky;
+		for (int i = 1; i <= 20; i++) {
+			if (i % 5 == 0) EXPECT_THROW(picky.emplace_back(i), std::invalid_argument);
+			else picky.emplace_back(i);
+		}
+		EXPECT_TRUE(picky.size() == 16);
+		EXPECT_TRUE(std::ranges::distance(picky) == 16);
+		EXPECT_TRUE(std::ranges::find(picky, std::string("6"), &Picky::text)->text == "6");
+
+		// Value-initialized iterators compare equal, as forward iterators must.
+		ConcurrentChunkList<int, 4>::const_iterator none1{};
+		ConcurrentChunkList<int, 4>::const_iterator none2{};
+		EXPECT_TRUE(none1 == none2);
+		EXPECT_TRUE(none1 == std::default_sentinel);
+	}
+
+	TEST(Concurrency, SnapshotCopyOnWrite)
+	{
+		ChunkList<std::string, 8> list;
+		for (int i = 0; i < 100; i++) list.push_back(std::to_string(i));
+		auto snapshot = list.snapshot();
+		std::vector<std::string> expected(snapshot.begin(), snapshot.end());
+		EXPECT_TRUE(snapshot.size() == 100 && snapshot[42] == "42" && snapshot.back() == "99");
+
+		// Only the written chunks are copied, the others stay shared.
+		list[3] = "three";
+		list.push_back("100");
+		const auto& view = list;
+		EXPECT_TRUE(view.chunks()[0].data() != snapshot.chunks()[0].data());
+		EXPECT_TRUE(view.chunks()[5].data() == snapshot.chunks()[5].data());
+		EXPECT_TRUE(view.chunks()[12].data() != snapshot.chunks()[12].data());
+		EXPECT_TRUE(view[3] == "three" && snapshot[3] == "3");
+
+		list.pop_front();
+		list.push_front("front");
+		list.resize(60);
+		list.back() = "back";
+		list.insert(list.cbegin() + 20, 5, "new");
+		list.erase(list.cbegin() + 3, list.cbegin() + 30);
+		for (std::string& value : list) value += "!";
+		EXPECT_TRUE(list.front() == "front!" && list.size() == 38);
+		EXPECT_TRUE(std::equal(expected.begin(), expected.end(), snapshot.begin(), snapshot.end()));
+		EXPECT_TRUE(snapshot.end() - snapshot.begin() == 100);
+		EXPECT_TRUE(*(snapshot.rbegin() + 1) == "98");
+
+		// Inserts and erases in the middle copy only the few of the 100 chunks
+		// they touch, and the returned iterator may write the element it points
+		// to.
+		ChunkList<int, 16> large;
+		for (int i = 0; i < 1600; i++) large.push_back(i);
+		auto before = large.snapshot();
+		std::size_t allocations = large.stats().chunk_allocations;
+		*large.insert(large.cbegin() + 800, -1) = -2;
+		*large.emplace(large.cbegin() + 400, -3) = -4;
+		*large.erase(large.cbegin() + 1200, large.cbegin() + 1220) = -5;
+		*large.erase(large.cbegin() + 100) = -6;
+		EXPECT_TRUE(large.stats().chunk_allocations - allocations <= 12);
+		EXPECT_TRUE(large[800] == -2 && large[399] == -4 && large[1199] == -5 && large[100] == -6);
+		EXPECT_TRUE(large.size() == 1581);
+		EXPECT_TRUE(std::ranges::equal(before, std::views::iota(0, 1600)));
+
+		// A snapshot outlives the list and releases the chunks it kept.
+		auto copy = snapshot;
+		list.clear();
+		snapshot = decltype(snapshot)();
+		EXPECT_TRUE(std::equal(expected.begin(), expected.end(), copy.begin(), copy.end()));
+
+		ChunkList<int, 16> numbers;
+		for (int i = 0; i < 10000; i++) numbers.push_back(i);
+		std::vector<std::thread> readers;
+		for (int round = 0; round < 8; round++) {
+			readers.emplace_back([view = numbers.snapshot(), round] {
+				long long total = 0;
+				for (int value : view) total += value;
+				EXPECT_TRUE(view.size() == static_cast<std::size_t>(10000 + round * 10));
+				EXPECT_TRUE(total == std::accumulate(view.begin(), view.end(), 0LL));
+			});
+			for (int i = 0; i < 20; i++) numbers[(i * 7919) % numbers.size()] += 1;
+			for (int i = 0; i < 10; i++) numbers.push_back(i);
+		}
+		for (std::thread& reader : readers) reader.join();
+	}
 }